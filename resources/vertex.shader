@@ -3,12 +3,18 @@
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aColor;
 
-uniform mat4 modelViewProjection;
+// shared by every program, filled once per frame from CameraUniformBuffer
+layout (std140) uniform Camera
+{
+  mat4 view;
+  mat4 projection;
+};
+uniform mat4 model;
 
 out vec3 outColor;
 
 void main()
 {
-  gl_Position = modelViewProjection * vec4(aPosition, 1.0f);
+  gl_Position = projection * view * model * vec4(aPosition, 1.0f);
   outColor = aColor;
 } 
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 330
+
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec3 aColor;
+// one model matrix per instance, takes locations 2 to 5
+layout (location = 2) in mat4 aInstanceModel;
+
+// shared by every program, filled once per frame from CameraUniformBuffer
+layout (std140) uniform Camera
+{
+  mat4 view;
+  mat4 projection;
+};
+uniform mat4 model;
+
+out vec3 outColor;
+
+void main()
+{
+  gl_Position = projection * view * model * aInstanceModel * vec4(aPosition, 1.0f);
+  outColor = aColor;
+}
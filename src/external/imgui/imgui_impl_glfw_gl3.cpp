@@ -64,6 +64,118 @@ static int          g_AttribLocationTex = 0, g_AttribLocationProjMtx = 0;
 static int          g_AttribLocationPosition = 0, g_AttribLocationUV = 0, g_AttribLocationColor = 0;
 static unsigned int g_VboHandle = 0, g_ElementsHandle = 0;
 
+// Streaming render mode data, see ImGui_ImplGlfwGL3_RenderMode
+static ImGui_ImplGlfwGL3_RenderMode g_RenderMode = ImGui_ImplGlfwGL3_RenderMode_Default;
+static unsigned int g_StreamVaoHandle = 0, g_StreamVboHandle = 0, g_StreamElementsHandle = 0;
+static size_t       g_StreamVboCapacity = 0, g_StreamElementsCapacity = 0;
+
+void ImGui_ImplGlfwGL3_SetRenderMode(ImGui_ImplGlfwGL3_RenderMode mode)
+{
+    g_RenderMode = mode;
+}
+
+ImGui_ImplGlfwGL3_RenderMode ImGui_ImplGlfwGL3_GetRenderMode()
+{
+    return g_RenderMode;
+}
+
+// Streaming render function: one upload per buffer and frame, no glGet*, a VAO that is kept
+static void ImGui_ImplGlfwGL3_RenderDrawDataStreaming(ImDrawData* draw_data, int fb_height)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    size_t vtx_size = (size_t)draw_data->TotalVtxCount * sizeof(ImDrawVert);
+    size_t idx_size = (size_t)draw_data->TotalIdxCount * sizeof(ImDrawIdx);
+    if (vtx_size == 0 || idx_size == 0)
+        return;
+
+    if (!g_StreamVaoHandle)
+    {
+        glGenVertexArrays(1, &g_StreamVaoHandle);
+        glGenBuffers(1, &g_StreamVboHandle);
+        glGenBuffers(1, &g_StreamElementsHandle);
+        glBindVertexArray(g_StreamVaoHandle);
+        glBindBuffer(GL_ARRAY_BUFFER, g_StreamVboHandle);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_StreamElementsHandle);
+        glEnableVertexAttribArray(g_AttribLocationPosition);
+        glEnableVertexAttribArray(g_AttribLocationUV);
+        glEnableVertexAttribArray(g_AttribLocationColor);
+        glVertexAttribPointer(g_AttribLocationPosition, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, pos));
+        glVertexAttribPointer(g_AttribLocationUV, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, uv));
+        glVertexAttribPointer(g_AttribLocationColor, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (GLvoid*)IM_OFFSETOF(ImDrawVert, col));
+    }
+    else
+    {
+        glBindVertexArray(g_StreamVaoHandle);
+        glBindBuffer(GL_ARRAY_BUFFER, g_StreamVboHandle);
+    }
+
+    // Orphan the previous frame's storage (the driver hands out a fresh block while the GPU still reads the old one),
+    // grown to the next power of two so the size settles after a few frames
+    while (g_StreamVboCapacity < vtx_size)
+        g_StreamVboCapacity = g_StreamVboCapacity ? g_StreamVboCapacity * 2 : 64 * 1024;
+    while (g_StreamElementsCapacity < idx_size)
+        g_StreamElementsCapacity = g_StreamElementsCapacity ? g_StreamElementsCapacity * 2 : 16 * 1024;
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)g_StreamVboCapacity, NULL, GL_STREAM_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)g_StreamElementsCapacity, NULL, GL_STREAM_DRAW);
+
+    size_t vtx_offset = 0, idx_offset = 0;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(vtx_offset * sizeof(ImDrawVert)), (GLsizeiptr)cmd_list->VtxBuffer.Size * sizeof(ImDrawVert), (const GLvoid*)cmd_list->VtxBuffer.Data);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr)(idx_offset * sizeof(ImDrawIdx)), (GLsizeiptr)cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx), (const GLvoid*)cmd_list->IdxBuffer.Data);
+        vtx_offset += cmd_list->VtxBuffer.Size;
+        idx_offset += cmd_list->IdxBuffer.Size;
+    }
+
+    // Only the state ImGui needs on top of what the caller guarantees
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    const float ortho_projection[4][4] =
+    {
+        { 2.0f/io.DisplaySize.x, 0.0f,                   0.0f, 0.0f },
+        { 0.0f,                  2.0f/-io.DisplaySize.y, 0.0f, 0.0f },
+        { 0.0f,                  0.0f,                  -1.0f, 0.0f },
+        {-1.0f,                  1.0f,                   0.0f, 1.0f },
+    };
+    glUseProgram(g_ShaderHandle);
+    glUniform1i(g_AttribLocationTex, 0);
+    glUniformMatrix4fv(g_AttribLocationProjMtx, 1, GL_FALSE, &ortho_projection[0][0]);
+
+    // Command lists follow each other in the buffers, indices stay relative to their list through the base vertex
+    vtx_offset = 0;
+    idx_offset = 0;
+    for (int n = 0; n < draw_data->CmdListsCount; n++)
+    {
+        const ImDrawList* cmd_list = draw_data->CmdLists[n];
+        for (int cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
+        {
+            const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
+            if (pcmd->UserCallback)
+            {
+                pcmd->UserCallback(cmd_list, pcmd);
+            }
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
+                glScissor((int)pcmd->ClipRect.x, (int)(fb_height - pcmd->ClipRect.w), (int)(pcmd->ClipRect.z - pcmd->ClipRect.x), (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
+                glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+                    (const GLvoid*)(idx_offset * sizeof(ImDrawIdx)), (GLint)vtx_offset);
+            }
+            idx_offset += pcmd->ElemCount;
+        }
+        vtx_offset += cmd_list->VtxBuffer.Size;
+    }
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
 // OpenGL3 Render function.
 // (this used to be set in io.RenderDrawListsFn and called by ImGui::Render(), but you can now call this directly from your main loop)
 // Note that this implementation is little overcomplicated because we are saving/setting up/restoring every OpenGL state explicitly, in order to be able to run within any OpenGL engine that doesn't do so. 
@@ -77,6 +189,12 @@ void ImGui_ImplGlfwGL3_RenderDrawData(ImDrawData* draw_data)
         return;
     draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
+    if (g_RenderMode == ImGui_ImplGlfwGL3_RenderMode_Streaming)
+    {
+        ImGui_ImplGlfwGL3_RenderDrawDataStreaming(draw_data, fb_height);
+        return;
+    }
+
     // Backup GL state
     GLenum last_active_texture; glGetIntegerv(GL_ACTIVE_TEXTURE, (GLint*)&last_active_texture);
     glActiveTexture(GL_TEXTURE0);
@@ -236,17 +354,22 @@ bool ImGui_ImplGlfwGL3_CreateFontsTexture()
     ImGuiIO& io = ImGui::GetIO();
     unsigned char* pixels;
     int width, height;
-    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);   // Load as RGBA 32-bits (75% of the memory is wasted, but default font is so small) because it is more likely to be compatible with user's existing shaders. If your ImTextureId represent a higher-level concept than just a GL texture id, consider calling GetTexDataAsAlpha8() instead to save on GPU memory.
+    io.Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);   // Load as Alpha 8-bits, a quarter of the RGBA32 memory. The swizzle below makes it sample as (1,1,1,alpha) like the RGBA32 data, so the shader is unchanged.
 
     // Upload texture to graphics system
-    GLint last_texture;
+    GLint last_texture, last_unpack_alignment;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &last_unpack_alignment);
     glGenTextures(1, &g_FontTexture);
     glBindTexture(GL_TEXTURE_2D, g_FontTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    const GLint swizzle[4] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, last_unpack_alignment);
 
     // Store our identifier
     io.Fonts->TexID = (void *)(intptr_t)g_FontTexture;
@@ -328,6 +451,12 @@ void    ImGui_ImplGlfwGL3_InvalidateDeviceObjects()
     if (g_ElementsHandle) glDeleteBuffers(1, &g_ElementsHandle);
     g_VboHandle = g_ElementsHandle = 0;
 
+    if (g_StreamVaoHandle) glDeleteVertexArrays(1, &g_StreamVaoHandle);
+    if (g_StreamVboHandle) glDeleteBuffers(1, &g_StreamVboHandle);
+    if (g_StreamElementsHandle) glDeleteBuffers(1, &g_StreamElementsHandle);
+    g_StreamVaoHandle = g_StreamVboHandle = g_StreamElementsHandle = 0;
+    g_StreamVboCapacity = g_StreamElementsCapacity = 0;
+
     if (g_ShaderHandle && g_VertHandle) glDetachShader(g_ShaderHandle, g_VertHandle);
     if (g_VertHandle) glDeleteShader(g_VertHandle);
     g_VertHandle = 0;
@@ -18,6 +18,20 @@ IMGUI_API void        ImGui_ImplGlfwGL3_Shutdown();
 IMGUI_API void        ImGui_ImplGlfwGL3_NewFrame();
 IMGUI_API void        ImGui_ImplGlfwGL3_RenderDrawData(ImDrawData* draw_data);
 
+// How ImGui_ImplGlfwGL3_RenderDrawData() uploads and draws.
+// Streaming writes every command list of the frame into one vertex/index buffer pair (orphaned once per frame,
+// grown when needed), draws with base vertex offsets and saves/restores no GL state. The caller guarantees
+// that on entry the viewport covers the framebuffer, GL_TEXTURE0 is active, blending, face culling and
+// scissoring are off and polygons are filled. On exit depth testing is on and blending/scissoring are off again,
+// program, texture, VAO and buffer bindings are left to whatever ImGui used last.
+enum ImGui_ImplGlfwGL3_RenderMode
+{
+    ImGui_ImplGlfwGL3_RenderMode_Default,   // glBufferData per command list, full state save/restore
+    ImGui_ImplGlfwGL3_RenderMode_Streaming
+};
+IMGUI_API void        ImGui_ImplGlfwGL3_SetRenderMode(ImGui_ImplGlfwGL3_RenderMode mode);
+IMGUI_API ImGui_ImplGlfwGL3_RenderMode ImGui_ImplGlfwGL3_GetRenderMode();
+
 // Use if you want to reset your rendering device without losing ImGui state.
 IMGUI_API void        ImGui_ImplGlfwGL3_InvalidateDeviceObjects();
 IMGUI_API bool        ImGui_ImplGlfwGL3_CreateDeviceObjects();
@@ -0,0 +1,116 @@
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<BoundingBox>& objectBounds)
+{
+	m_nodes.clear();
+	m_objectBounds = objectBounds;
+	m_objects.resize(objectBounds.size());
+	for (size_t i = 0; i < m_objects.size(); i++)
+		m_objects[i] = (unsigned int)i;
+	if (m_objects.empty()) return;
+
+	std::vector<glm::vec3> centers(objectBounds.size());
+	for (size_t i = 0; i < centers.size(); i++)
+		centers[i] = objectBounds[i].getCenter();
+
+	m_nodes.emplace_back();
+	BuildNode(objectBounds, centers, 0, 0, (unsigned int)m_objects.size());
+}
+
+void BoundingVolumeHierarchy::BuildNode(const std::vector<BoundingBox>& objectBounds, const std::vector<glm::vec3>& centers,
+	unsigned int nodeIndex, unsigned int first, unsigned int count)
+{
+	// Indices only, adding children may move the nodes
+	BoundingBox bounds;
+	BoundingBox centerBounds;
+	for (unsigned int i = first; i < first + count; i++)
+	{
+		bounds.Add(objectBounds[m_objects[i]]);
+		centerBounds.Add(centers[m_objects[i]]);
+	}
+	m_nodes[nodeIndex].bounds = bounds;
+
+	if (count <= maxLeafSize)
+	{
+		m_nodes[nodeIndex].first = first;
+		m_nodes[nodeIndex].count = count;
+		return;
+	}
+
+	// Median split along the axis the centers spread the most on
+	glm::vec3 extent = centerBounds.getExtent();
+	int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+	unsigned int half = count / 2;
+	std::nth_element(m_objects.begin() + first, m_objects.begin() + first + half, m_objects.begin() + first + count,
+		[&centers, axis](unsigned int a, unsigned int b) { return centers[a][axis] < centers[b][axis]; });
+
+	unsigned int leftIndex = (unsigned int)m_nodes.size();
+	m_nodes[nodeIndex].first = leftIndex;
+	m_nodes[nodeIndex].count = 0;
+	m_nodes.emplace_back();
+	m_nodes.emplace_back();
+
+	BuildNode(objectBounds, centers, leftIndex, first, half);
+	BuildNode(objectBounds, centers, leftIndex + 1, first + half, count - half);
+}
+
+void BoundingVolumeHierarchy::Query(const Frustum& frustum, std::vector<unsigned int>& visibleObjects) const
+{
+	visibleObjects.clear();
+	if (m_nodes.empty()) return;
+
+	// Explicit stack, a median split tree over the largest grids stays well under 64 levels
+	unsigned int stack[64];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		unsigned int nodeIndex = stack[--stackSize];
+		const Node& node = m_nodes[nodeIndex];
+
+		FrustumTest test = frustum.Test(node.bounds);
+		if (test == FrustumTest::Outside) continue;
+		if (test == FrustumTest::Inside)
+		{
+			AddSubtree(nodeIndex, visibleObjects);
+			continue;
+		}
+
+		if (node.count > 0)
+		{
+			// Straddling leaf, its objects are tested one by one
+			for (unsigned int i = node.first; i < node.first + node.count; i++)
+			{
+				if (frustum.IsVisible(m_objectBounds[m_objects[i]]))
+					visibleObjects.push_back(m_objects[i]);
+			}
+			continue;
+		}
+
+		stack[stackSize++] = node.first + 1;
+		stack[stackSize++] = node.first;
+	}
+}
+
+void BoundingVolumeHierarchy::AddSubtree(unsigned int nodeIndex, std::vector<unsigned int>& visibleObjects) const
+{
+	// Every node covers a contiguous object range, so the subtree is the range from its leftmost to its rightmost leaf
+	unsigned int leftmost = nodeIndex, rightmost = nodeIndex;
+	while (m_nodes[leftmost].count == 0) leftmost = m_nodes[leftmost].first;
+	while (m_nodes[rightmost].count == 0) rightmost = m_nodes[rightmost].first + 1;
+
+	unsigned int first = m_nodes[leftmost].first;
+	unsigned int last = m_nodes[rightmost].first + m_nodes[rightmost].count;
+	visibleObjects.insert(visibleObjects.end(), m_objects.begin() + first, m_objects.begin() + last);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <vector>
+
+#include "Frustum.h"
+
+// Binary tree of boxes over a set of objects, built once from their bounds and queried per frame.
+// Whole subtrees outside the frustum are skipped and subtrees fully inside are taken without more tests.
+class BoundingVolumeHierarchy
+{
+public:
+	BoundingVolumeHierarchy();
+	~BoundingVolumeHierarchy();
+
+	// Object i of the queries is objectBounds[i]
+	void Build(const std::vector<BoundingBox>& objectBounds);
+	// Replaces visibleObjects with the objects touching the frustum, in tree order
+	void Query(const Frustum& frustum, std::vector<unsigned int>& visibleObjects) const;
+
+	inline size_t getObjectCount() const { return m_objects.size(); }
+	inline size_t getNodeCount() const { return m_nodes.size(); }
+
+	// Leaves hold up to this many objects, testing a few boxes beats another level of nodes
+	static const unsigned int maxLeafSize = 8;
+private:
+	struct Node
+	{
+		BoundingBox bounds;
+		// Leaf: m_objects[first .. first + count). Inner node: children at first and first + 1, count 0
+		unsigned int first = 0;
+		unsigned int count = 0;
+	};
+
+	void BuildNode(const std::vector<BoundingBox>& objectBounds, const std::vector<glm::vec3>& centers,
+		unsigned int nodeIndex, unsigned int first, unsigned int count);
+	void AddSubtree(unsigned int nodeIndex, std::vector<unsigned int>& visibleObjects) const;
+
+	std::vector<Node> m_nodes;
+	// Kept for the objects of leaves straddling a frustum plane
+	std::vector<BoundingBox> m_objectBounds;
+	// Object indices reordered so every node covers a contiguous range
+	std::vector<unsigned int> m_objects;
+};
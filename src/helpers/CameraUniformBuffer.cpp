@@ -0,0 +1,44 @@
+#include "CameraUniformBuffer.h"
+
+#include <glew.h>
+
+const char* const CameraUniformBuffer::blockName = "Camera";
+
+CameraUniformBuffer::CameraUniformBuffer()
+{
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraUniforms), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+CameraUniformBuffer::~CameraUniformBuffer()
+{
+	glDeleteBuffers(1, &m_buffer);
+}
+
+bool CameraUniformBuffer::Update(const MatrixCache& matrixCache)
+{
+	if (m_uploaded && matrixCache.getViewUpdateCount() == m_viewUpdateCount &&
+		matrixCache.getProjectionUpdateCount() == m_projectionUpdateCount) return false;
+
+	CameraUniforms uniforms;
+	uniforms.view = matrixCache.getViewMatrix();
+	uniforms.projection = matrixCache.getProjectionMatrix();
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(uniforms), &uniforms);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	m_uploaded = true;
+	m_viewUpdateCount = matrixCache.getViewUpdateCount();
+	m_projectionUpdateCount = matrixCache.getProjectionUpdateCount();
+	m_uploadCount++;
+
+	return true;
+}
+
+void CameraUniformBuffer::Bind()
+{
+	glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, m_buffer);
+}
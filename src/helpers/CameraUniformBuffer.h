@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "MatrixCache.h"
+
+// Camera block as laid out by std140, two column major mat4 need no padding
+struct CameraUniforms
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+};
+static_assert(sizeof(CameraUniforms) == 128, "CameraUniforms must match the std140 Camera block");
+
+// Uniform buffer holding the view and projection matrices for every program declaring the Camera block.
+// Bound once per frame, so draws only upload their own model matrix.
+class CameraUniformBuffer
+{
+public:
+	CameraUniformBuffer();
+	~CameraUniformBuffer();
+
+	// Uploads when the view or projection stage of the cache ran since the last upload, returns true then
+	bool Update(const MatrixCache& matrixCache);
+	void Bind();
+
+	inline unsigned int getUploadCount() const { return m_uploadCount; }
+
+	static const unsigned int bindingPoint = 0;
+	static const char* const blockName;
+private:
+	unsigned int m_buffer = 0;
+	bool m_uploaded = false;
+	unsigned int m_viewUpdateCount = 0;
+	unsigned int m_projectionUpdateCount = 0;
+	unsigned int m_uploadCount = 0;
+};
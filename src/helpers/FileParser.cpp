@@ -1,5 +1,8 @@
 #include "FileParser.h"
 
+#include <cstdio>
+#include <cstring>
+
 std::string ReadResourceFileToStr(const std::string& filePath)
 {
 	std::cout << "something something " << filePath << std::endl;
@@ -8,7 +11,12 @@ std::string ReadResourceFileToStr(const std::string& filePath)
 	if (!fileStream) {
 		printf("file opening failed: ");
 		char errorMessage[1024];
+#ifdef _WIN32
 		strerror_s(errorMessage, 1024, errno);
+#else
+		// strerror_s is MSVC only, strerror is fine on the single render thread reading resources
+		snprintf(errorMessage, sizeof(errorMessage), "%s", strerror(errno));
+#endif
 		std::cerr << "error: " << errorMessage << std::endl;
 
 		return "Whoopsies";
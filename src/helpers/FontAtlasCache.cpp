@@ -0,0 +1,241 @@
+#include "FontAtlasCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "../external/imgui/imgui.h"
+#include "../external/imgui/imgui_internal.h"
+
+static const char fontAtlasMagic[4] = { 'M', 'V', 'F', 'A' };
+static const uint32_t fontAtlasVersion = 1;
+
+// FNV-1a over raw bytes
+static void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+}
+
+template <typename T>
+static void hashValue(uint64_t& hash, const T& value)
+{
+	hashBytes(hash, &value, sizeof(value));
+}
+
+static int fontIndex(const ImFontAtlas& atlas, const ImFont* font)
+{
+	for (int i = 0; i < atlas.Fonts.Size; i++)
+		if (atlas.Fonts[i] == font) return i;
+	return -1;
+}
+
+// Everything ImFontAtlasBuildWithStbTruetype reads, the TTF data included
+static uint64_t atlasKey(const ImFontAtlas& atlas)
+{
+	uint64_t hash = 14695981039346656037ull;
+	hashBytes(hash, IMGUI_VERSION, sizeof(IMGUI_VERSION));
+	hashValue(hash, fontAtlasVersion);
+	hashValue(hash, sizeof(ImFontGlyph));
+	hashValue(hash, atlas.Flags);
+	hashValue(hash, atlas.TexDesiredWidth);
+	hashValue(hash, atlas.TexGlyphPadding);
+	hashValue(hash, atlas.Fonts.Size);
+
+	for (const ImFontConfig& config : atlas.ConfigData)
+	{
+		hashValue(hash, config.FontDataSize);
+		hashBytes(hash, config.FontData, (size_t)config.FontDataSize);
+		hashValue(hash, config.FontNo);
+		hashValue(hash, config.SizePixels);
+		hashValue(hash, config.OversampleH);
+		hashValue(hash, config.OversampleV);
+		hashValue(hash, config.PixelSnapH);
+		hashValue(hash, config.GlyphExtraSpacing.x);
+		hashValue(hash, config.GlyphExtraSpacing.y);
+		hashValue(hash, config.GlyphOffset.x);
+		hashValue(hash, config.GlyphOffset.y);
+		hashValue(hash, config.MergeMode);
+		hashValue(hash, config.RasterizerFlags);
+		hashValue(hash, config.RasterizerMultiply);
+		hashValue(hash, fontIndex(atlas, config.DstFont));
+
+		// Ranges end with a 0 pair, the terminator is hashed too so [a b][c d] differs from [a b c d]
+		const ImWchar* range = config.GlyphRanges;
+		for (; range[0] && range[1]; range += 2) hashBytes(hash, range, sizeof(ImWchar) * 2);
+		hashValue(hash, range[0]);
+	}
+
+	for (const ImFontAtlas::CustomRect& rect : atlas.CustomRects)
+	{
+		hashValue(hash, rect.ID);
+		hashValue(hash, rect.Width);
+		hashValue(hash, rect.Height);
+		hashValue(hash, rect.GlyphAdvanceX);
+		hashValue(hash, rect.GlyphOffset.x);
+		hashValue(hash, rect.GlyphOffset.y);
+		hashValue(hash, fontIndex(atlas, rect.Font));
+	}
+
+	return hash;
+}
+
+// Reads the whole file before touching the atlas, a truncated or stale file leaves it as it was
+static bool loadAtlas(ImFontAtlas& atlas, const std::string& cachePath, uint64_t key)
+{
+	std::ifstream file(cachePath, std::ios::binary);
+	if (!file) return false;
+
+	FontAtlasFileHeader header;
+	if (!file.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, fontAtlasMagic, 4) != 0) return false;
+	if (header.version != fontAtlasVersion || header.key != key || header.width <= 0 || header.height <= 0 ||
+		header.configCount != (uint32_t)atlas.ConfigData.Size || header.customRectCount != (uint32_t)atlas.CustomRects.Size ||
+		header.fontCount != (uint32_t)atlas.Fonts.Size) return false;
+
+	std::vector<float> metrics(header.configCount * 2);
+	std::vector<uint16_t> rectPositions(header.customRectCount * 2);
+	if (!file.read((char*)metrics.data(), metrics.size() * sizeof(float))) return false;
+	if (!file.read((char*)rectPositions.data(), rectPositions.size() * sizeof(uint16_t))) return false;
+
+	std::vector<int32_t> surfaces(header.fontCount);
+	std::vector<std::vector<ImFontGlyph>> glyphs(header.fontCount);
+	for (uint32_t font = 0; font < header.fontCount; font++)
+	{
+		uint32_t glyphCount = 0;
+		if (!file.read((char*)&surfaces[font], sizeof(int32_t)) || !file.read((char*)&glyphCount, sizeof(glyphCount))) return false;
+		// ImFont indexes glyphs with 16 bits
+		if (glyphCount >= 0xFFFF) return false;
+		glyphs[font].resize(glyphCount);
+		if (!file.read((char*)glyphs[font].data(), glyphCount * sizeof(ImFontGlyph))) return false;
+	}
+
+	size_t pixelCount = (size_t)header.width * header.height;
+	unsigned char* pixels = (unsigned char*)ImGui::MemAlloc(pixelCount);
+	if (!file.read((char*)pixels, pixelCount)) {
+		ImGui::MemFree(pixels);
+		return false;
+	}
+
+	// What ImFontAtlasBuildWithStbTruetype leaves behind, with the glyphs and pixels it would have produced
+	atlas.ClearTexData();
+	atlas.TexID = NULL;
+	atlas.TexPixelsAlpha8 = pixels;
+	atlas.TexWidth = header.width;
+	atlas.TexHeight = header.height;
+	atlas.TexUvScale = ImVec2(1.0f / header.width, 1.0f / header.height);
+	atlas.TexUvWhitePixel = ImVec2(header.whitePixelU, header.whitePixelV);
+
+	for (uint32_t rect = 0; rect < header.customRectCount; rect++)
+	{
+		atlas.CustomRects[rect].X = rectPositions[rect * 2];
+		atlas.CustomRects[rect].Y = rectPositions[rect * 2 + 1];
+	}
+
+	for (uint32_t config = 0; config < header.configCount; config++)
+	{
+		ImFontConfig& fontConfig = atlas.ConfigData[config];
+		ImFontAtlasBuildSetupFont(&atlas, fontConfig.DstFont, &fontConfig, metrics[config * 2], metrics[config * 2 + 1]);
+	}
+
+	for (uint32_t font = 0; font < header.fontCount; font++)
+	{
+		ImFont* target = atlas.Fonts[font];
+		target->Glyphs.resize((int)glyphs[font].size());
+		if (!glyphs[font].empty()) std::memcpy(target->Glyphs.Data, glyphs[font].data(), glyphs[font].size() * sizeof(ImFontGlyph));
+		target->MetricsTotalSurface = surfaces[font];
+		target->BuildLookupTable();
+	}
+
+	return true;
+}
+
+static bool saveAtlas(const ImFontAtlas& atlas, const std::string& cacheDirectory, const std::string& cachePath, uint64_t key)
+{
+	FontAtlasFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, fontAtlasMagic, 4);
+	header.version = fontAtlasVersion;
+	header.key = key;
+	header.width = atlas.TexWidth;
+	header.height = atlas.TexHeight;
+	header.configCount = (uint32_t)atlas.ConfigData.Size;
+	header.customRectCount = (uint32_t)atlas.CustomRects.Size;
+	header.fontCount = (uint32_t)atlas.Fonts.Size;
+	header.whitePixelU = atlas.TexUvWhitePixel.x;
+	header.whitePixelV = atlas.TexUvWhitePixel.y;
+
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+	std::ofstream file(cachePath, std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+
+	file.write((const char*)&header, sizeof(header));
+	for (const ImFontConfig& config : atlas.ConfigData)
+	{
+		// Merged configs do not set the metrics, their values are written but not used
+		float metrics[2] = { config.DstFont->Ascent, config.DstFont->Descent };
+		file.write((const char*)metrics, sizeof(metrics));
+	}
+	for (const ImFontAtlas::CustomRect& rect : atlas.CustomRects)
+	{
+		uint16_t position[2] = { rect.X, rect.Y };
+		file.write((const char*)position, sizeof(position));
+	}
+	for (const ImFont* font : atlas.Fonts)
+	{
+		int32_t surface = font->MetricsTotalSurface;
+		uint32_t glyphCount = (uint32_t)font->Glyphs.Size;
+		file.write((const char*)&surface, sizeof(surface));
+		file.write((const char*)&glyphCount, sizeof(glyphCount));
+		file.write((const char*)font->Glyphs.Data, glyphCount * sizeof(ImFontGlyph));
+	}
+	file.write((const char*)atlas.TexPixelsAlpha8, (size_t)atlas.TexWidth * atlas.TexHeight);
+
+	return (bool)file;
+}
+
+bool BuildFontAtlas(ImFontAtlas& atlas, const std::string& cacheDirectory, FontAtlasBuildInfo& info)
+{
+	auto buildStart = std::chrono::steady_clock::now();
+	info = FontAtlasBuildInfo();
+
+	// The same defaults the build applies, so they are part of the key
+	if (atlas.ConfigData.empty()) atlas.AddFontDefault();
+	ImFontAtlasBuildRegisterDefaultCustomRects(&atlas);
+	for (ImFontConfig& config : atlas.ConfigData)
+		if (!config.GlyphRanges) config.GlyphRanges = atlas.GetGlyphRangesDefault();
+
+	uint64_t key = 0;
+	if (!cacheDirectory.empty())
+	{
+		key = atlasKey(atlas);
+		char fileName[32];
+		std::snprintf(fileName, sizeof(fileName), "%016llx.mvfont", (unsigned long long)key);
+		info.cachePath = cacheDirectory + "/" + fileName;
+		info.loadedFromCache = loadAtlas(atlas, info.cachePath, key);
+	}
+
+	if (!info.loadedFromCache)
+	{
+		if (!atlas.Build()) return false;
+		if (!cacheDirectory.empty()) info.savedToCache = saveAtlas(atlas, cacheDirectory, info.cachePath, key);
+	}
+
+	info.width = atlas.TexWidth;
+	info.height = atlas.TexHeight;
+	for (const ImFont* font : atlas.Fonts) info.glyphCount += font->Glyphs.Size;
+	info.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+	return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ImFontAtlas;
+
+// Font atlas cache file (.mvfont), little endian:
+//   FontAtlasFileHeader | ascent, descent per font config | X, Y per custom rect
+//   | per font: metrics surface, glyph count, ImFontGlyph array | Alpha8 pixels, TexWidth * TexHeight bytes
+// The file name is a hash of everything the build reads, so a changed font, size or glyph range gets a new file.
+struct FontAtlasFileHeader
+{
+	char magic[4];          // "MVFA"
+	uint32_t version;
+	uint64_t key;           // hash of the build inputs, also in the file name
+	int32_t width;
+	int32_t height;
+	uint32_t configCount;
+	uint32_t customRectCount;
+	uint32_t fontCount;
+	uint32_t reserved;
+	float whitePixelU;
+	float whitePixelV;
+};
+static_assert(sizeof(FontAtlasFileHeader) == 48, "FontAtlasFileHeader is written to disk as is");
+
+struct FontAtlasBuildInfo
+{
+	bool loadedFromCache = false;
+	// The cache file was written after a rasterizing build
+	bool savedToCache = false;
+	double buildMs = 0.0;
+	int width = 0;
+	int height = 0;
+	int glyphCount = 0;
+	std::string cachePath = "";
+};
+
+// Builds the atlas like ImFontAtlas::Build (adding the default font when none was added), or loads the glyph
+// tables and Alpha8 pixels an earlier identical build saved to cacheDirectory, skipping the rasterizer.
+// An empty directory always rasterizes. Call before the renderer asks for the texture data.
+bool BuildFontAtlas(ImFontAtlas& atlas, const std::string& cacheDirectory, FontAtlasBuildInfo& info);
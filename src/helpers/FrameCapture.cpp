@@ -0,0 +1,358 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// ---- PNG without a compression library: zlib stream made of stored deflate blocks
+
+struct Crc32Table
+{
+	uint32_t entries[256];
+
+	Crc32Table()
+	{
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t c = n;
+			for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+			entries[n] = c;
+		}
+	}
+};
+
+static uint32_t crc32(const unsigned char* data, size_t size)
+{
+	// Built on first use, static initialization is thread safe
+	static const Crc32Table table;
+
+	uint32_t crc = 0xFFFFFFFFu;
+	for (size_t i = 0; i < size; i++) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void appendBigEndian(std::vector<unsigned char>& out, uint32_t value)
+{
+	out.push_back((unsigned char)(value >> 24));
+	out.push_back((unsigned char)(value >> 16));
+	out.push_back((unsigned char)(value >> 8));
+	out.push_back((unsigned char)value);
+}
+
+static void appendChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+{
+	appendBigEndian(out, (uint32_t)data.size());
+	size_t typeStart = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), data.begin(), data.end());
+	appendBigEndian(out, crc32(out.data() + typeStart, out.size() - typeStart));
+}
+
+static std::vector<unsigned char> encodePng(const unsigned char* rgba, int width, int height)
+{
+	// Filter byte 0 then RGB for every row, GL rows are bottom up
+	size_t rowSize = 1 + (size_t)width * 3;
+	std::vector<unsigned char> scanlines(rowSize * height);
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char* source = rgba + (size_t)(height - 1 - y) * width * 4;
+		unsigned char* row = scanlines.data() + rowSize * y;
+		row[0] = 0;
+		for (int x = 0; x < width; x++)
+		{
+			row[1 + x * 3] = source[x * 4];
+			row[2 + x * 3] = source[x * 4 + 1];
+			row[3 + x * 3] = source[x * 4 + 2];
+		}
+	}
+
+	const size_t maxBlock = 65535;
+	std::vector<unsigned char> zlib;
+	zlib.reserve(scanlines.size() + scanlines.size() / maxBlock * 5 + 16);
+	zlib.push_back(0x78);
+	zlib.push_back(0x01);
+	uint32_t adlerA = 1, adlerB = 0;
+	for (size_t offset = 0; ; offset += maxBlock)
+	{
+		size_t blockSize = std::min(maxBlock, scanlines.size() - offset);
+		bool last = offset + blockSize >= scanlines.size();
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back((unsigned char)blockSize);
+		zlib.push_back((unsigned char)(blockSize >> 8));
+		zlib.push_back((unsigned char)~blockSize);
+		zlib.push_back((unsigned char)(~blockSize >> 8));
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+		// 5552 bytes is the most that can be summed before the 32-bit sums need reducing
+		for (size_t run = offset; run < offset + blockSize; run += 5552)
+		{
+			size_t runEnd = std::min(run + 5552, offset + blockSize);
+			for (size_t i = run; i < runEnd; i++)
+			{
+				adlerA += scanlines[i];
+				adlerB += adlerA;
+			}
+			adlerA %= 65521;
+			adlerB %= 65521;
+		}
+		if (last) break;
+	}
+	appendBigEndian(zlib, (adlerB << 16) | adlerA);
+
+	std::vector<unsigned char> header;
+	appendBigEndian(header, (uint32_t)width);
+	appendBigEndian(header, (uint32_t)height);
+	header.push_back(8); // bit depth
+	header.push_back(2); // RGB
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	std::vector<unsigned char> png(signature, signature + 8);
+	appendChunk(png, "IHDR", header);
+	appendChunk(png, "IDAT", zlib);
+	appendChunk(png, "IEND", std::vector<unsigned char>());
+	return png;
+}
+
+// ---- FrameCapture
+
+FrameCapture::FrameCapture(const std::string& directory, CaptureFormat format, int ringSize)
+	: m_directory(directory), m_format(format), m_ringSize(std::min(std::max(2, ringSize), maxRingSize))
+{
+#ifdef _WIN32
+	_mkdir(m_directory.c_str());
+#else
+	mkdir(m_directory.c_str(), 0755);
+#endif
+
+	m_encoder = std::thread(&FrameCapture::EncoderLoop, this);
+}
+
+FrameCapture::~FrameCapture()
+{
+	Finish();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_changed.notify_all();
+	m_encoder.join();
+
+	for (int slot = 0; slot < m_ringSize; slot++)
+	{
+		if (m_ring[slot].fence) glDeleteSync(m_ring[slot].fence);
+		if (m_ring[slot].buffer) glDeleteBuffers(1, &m_ring[slot].buffer);
+	}
+}
+
+void FrameCapture::Capture(int width, int height)
+{
+	unsigned int frameNumber = m_frameNumber++;
+	if (width <= 0 || height <= 0) return;
+
+	Collect(false);
+	if (m_pendingCount == m_ringSize)
+	{
+		// The GPU has not finished a whole ring of readbacks, waiting here would cost the frame rate
+		m_droppedCount++;
+		return;
+	}
+
+	PixelBuffer& pixelBuffer = m_ring[m_next];
+	size_t size = (size_t)width * height * 4;
+	if (!pixelBuffer.buffer) glGenBuffers(1, &pixelBuffer.buffer);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+	if (pixelBuffer.size != size)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+		pixelBuffer.size = size;
+	}
+
+	// Into the buffer, so the call returns right away and the copy happens when the GPU gets there
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pixelBuffer.frameNumber = frameNumber;
+	pixelBuffer.width = width;
+	pixelBuffer.height = height;
+
+	m_next = (m_next + 1) % m_ringSize;
+	m_pendingCount++;
+	m_capturedCount++;
+}
+
+void FrameCapture::Collect(bool wait)
+{
+	while (m_pendingCount > 0)
+	{
+		PixelBuffer& pixelBuffer = m_ring[(m_next - m_pendingCount + m_ringSize) % m_ringSize];
+
+		GLenum result = glClientWaitSync(pixelBuffer.fence, 0, 0);
+		if (result == GL_TIMEOUT_EXPIRED)
+		{
+			// Readbacks finish in order, a later one cannot be done yet either
+			if (!wait) return;
+			do
+			{
+				result = glClientWaitSync(pixelBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+			} while (result == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(pixelBuffer.fence);
+		pixelBuffer.fence = nullptr;
+		Queue(pixelBuffer);
+		m_pendingCount--;
+	}
+}
+
+void FrameCapture::Queue(PixelBuffer& pixelBuffer)
+{
+	EncodeJob job;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_queue.size() >= maxQueuedFrames)
+		{
+			// The encoder (or the disk) is behind, the frame is lost rather than the frame rate
+			m_droppedCount++;
+			return;
+		}
+		if (!m_freePixels.empty())
+		{
+			job.pixels.swap(m_freePixels.back());
+			m_freePixels.pop_back();
+		}
+	}
+
+	job.frameNumber = pixelBuffer.frameNumber;
+	job.width = pixelBuffer.width;
+	job.height = pixelBuffer.height;
+	job.pixels.resize(pixelBuffer.size);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+	const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pixelBuffer.size, GL_MAP_READ_BIT);
+	if (pixels)
+	{
+		std::memcpy(job.pixels.data(), pixels, pixelBuffer.size);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (pixels) m_queue.push_back(std::move(job));
+		else
+		{
+			// Nothing was read back, writing the vector would save a stale or blank frame
+			m_failedCount++;
+			m_freePixels.push_back(std::move(job.pixels));
+		}
+	}
+	m_changed.notify_all();
+}
+
+void FrameCapture::Finish()
+{
+	Collect(true);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this]() { return m_queue.empty() && !m_encoding; });
+}
+
+unsigned int FrameCapture::GetWrittenCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_writtenCount;
+}
+
+unsigned int FrameCapture::GetQueuedCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (unsigned int)m_queue.size() + (m_encoding ? 1 : 0) + m_pendingCount;
+}
+
+unsigned int FrameCapture::GetFailedCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_failedCount;
+}
+
+void FrameCapture::EncoderLoop()
+{
+	for (;;)
+	{
+		EncodeJob job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_changed.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty()) break;
+
+			job = std::move(m_queue.front());
+			m_queue.pop_front();
+			m_encoding = true;
+		}
+
+		bool written = Write(job);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (written) m_writtenCount++;
+			else m_failedCount++;
+			m_freePixels.push_back(std::move(job.pixels));
+			m_encoding = false;
+		}
+		m_changed.notify_all();
+	}
+}
+
+bool FrameCapture::Write(const EncodeJob& job)
+{
+	// Raw files carry their size in the name, a resized window changes it mid-sequence
+	char fileName[64];
+	if (m_format == CaptureFormat::Png)
+		std::snprintf(fileName, sizeof(fileName), "frame_%06u.png", job.frameNumber);
+	else
+		std::snprintf(fileName, sizeof(fileName), "frame_%06u_%dx%d.raw", job.frameNumber, job.width, job.height);
+	std::ofstream file(m_directory + "/" + fileName, std::ios::binary);
+	if (!file) return false;
+
+	if (m_format == CaptureFormat::Png)
+	{
+		std::vector<unsigned char> png = encodePng(job.pixels.data(), job.width, job.height);
+		file.write((const char*)png.data(), png.size());
+	}
+	else
+	{
+		// Top row first, like the PNG files
+		size_t rowSize = (size_t)job.width * 4;
+		for (int y = job.height - 1; y >= 0; y--)
+			file.write((const char*)job.pixels.data() + rowSize * y, rowSize);
+	}
+	return (bool)file;
+}
+
+const char* FrameCapture::GetFormatName(CaptureFormat format)
+{
+	return format == CaptureFormat::Raw ? "raw" : "png";
+}
+
+bool FrameCapture::ParseFormat(const std::string& name, CaptureFormat& format)
+{
+	if (name == "png") format = CaptureFormat::Png;
+	else if (name == "raw") format = CaptureFormat::Raw;
+	else return false;
+	return true;
+}
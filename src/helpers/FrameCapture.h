@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glew.h>
+
+enum class CaptureFormat
+{
+	Png,    // 8-bit RGB, stored without compression so the encoder keeps up
+	Raw     // RGBA8 rows top to bottom, no header, the size is in the file name
+};
+
+// Saves rendered frames as an image sequence without stalling the render thread.
+// Capture reads the framebuffer into the next pixel buffer object of a ring and fences it; the pixels are mapped
+// a few frames later, once the fence signaled, and handed to an encoder thread writing one file per frame.
+// Frames are dropped (and counted) instead of waiting when the ring or the encoder queue is full.
+// Needs a current OpenGL context, Capture and Finish run on the render thread.
+class FrameCapture
+{
+public:
+	// Files are written to directory/frame_000000.png (or frame_000000_WxH.raw), the directory is created if missing.
+	// The number counts Capture calls, dropped frames leave gaps
+	FrameCapture(const std::string& directory, CaptureFormat format, int ringSize = defaultRingSize);
+	~FrameCapture();
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	// After the frame is drawn, reads width x height pixels of the bound read framebuffer
+	void Capture(int width, int height);
+	// Waits for every pending readback and for the encoder to write them
+	void Finish();
+
+	inline const std::string& getDirectory() const { return m_directory; }
+	inline CaptureFormat getFormat() const { return m_format; }
+	// Readbacks issued, each one is later written, failed or dropped when the encoder queue was full
+	inline unsigned int getCapturedCount() const { return m_capturedCount; }
+	inline unsigned int getDroppedCount() const { return m_droppedCount; }
+	unsigned int GetWrittenCount();
+	unsigned int GetQueuedCount();
+	// Files the encoder could not write
+	unsigned int GetFailedCount();
+
+	static const char* GetFormatName(CaptureFormat format);
+	static bool ParseFormat(const std::string& name, CaptureFormat& format);
+
+	static const int defaultRingSize = 3;
+	static const int maxRingSize = 8;
+	// Frames mapped but not written yet, more are dropped
+	static const size_t maxQueuedFrames = 8;
+private:
+	struct PixelBuffer
+	{
+		unsigned int buffer = 0;
+		size_t size = 0;
+		GLsync fence = nullptr;
+		unsigned int frameNumber = 0;
+		int width = 0, height = 0;
+	};
+
+	struct EncodeJob
+	{
+		unsigned int frameNumber = 0;
+		int width = 0, height = 0;
+		std::vector<unsigned char> pixels;
+	};
+
+	// Maps the readbacks that finished, oldest first, and queues them. With wait it blocks until all of them did
+	void Collect(bool wait);
+	void Queue(PixelBuffer& pixelBuffer);
+	void EncoderLoop();
+	bool Write(const EncodeJob& job);
+
+	std::string m_directory;
+	CaptureFormat m_format;
+
+	PixelBuffer m_ring[maxRingSize];
+	int m_ringSize;
+	// Next slot to read into, pending slots follow it in capture order
+	int m_next = 0;
+	int m_pendingCount = 0;
+
+	unsigned int m_frameNumber = 0;
+	unsigned int m_capturedCount = 0;
+	unsigned int m_droppedCount = 0;
+
+	std::thread m_encoder;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::deque<EncodeJob> m_queue;
+	// Pixel vectors handed back by the encoder, reused so capturing does not allocate every frame
+	std::vector<std::vector<unsigned char>> m_freePixels;
+	bool m_encoding = false;
+	bool m_stopping = false;
+	unsigned int m_writtenCount = 0;
+	unsigned int m_failedCount = 0;
+};
@@ -0,0 +1,100 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+FrameStats::FrameStats()
+{
+}
+
+FrameStats::~FrameStats()
+{
+}
+
+void FrameStats::AddFrame(double frameTimeMs)
+{
+	m_frameTimesMs.push_back(frameTimeMs);
+	m_totalMs += frameTimeMs;
+}
+
+void FrameStats::Clear()
+{
+	m_frameTimesMs.clear();
+	m_totalMs = 0.0;
+}
+
+double FrameStats::GetMinMs() const
+{
+	if (m_frameTimesMs.empty()) return 0.0;
+	return *std::min_element(m_frameTimesMs.begin(), m_frameTimesMs.end());
+}
+
+double FrameStats::GetMaxMs() const
+{
+	if (m_frameTimesMs.empty()) return 0.0;
+	return *std::max_element(m_frameTimesMs.begin(), m_frameTimesMs.end());
+}
+
+double FrameStats::GetAverageMs() const
+{
+	if (m_frameTimesMs.empty()) return 0.0;
+	return m_totalMs / (double)m_frameTimesMs.size();
+}
+
+double FrameStats::GetPercentileMs(double percentile) const
+{
+	if (m_frameTimesMs.empty()) return 0.0;
+
+	// Nearest-rank percentile on a sorted copy, the samples themselves stay in frame order
+	std::vector<double> sorted = m_frameTimesMs;
+	std::sort(sorted.begin(), sorted.end());
+	size_t rank = (size_t)std::ceil(percentile / 100.0 * (double)sorted.size());
+	if (rank < 1) rank = 1;
+	if (rank > sorted.size()) rank = sorted.size();
+
+	return sorted[rank - 1];
+}
+
+double FrameStats::GetFramesPerSecond() const
+{
+	if (m_totalMs <= 0.0) return 0.0;
+	return (double)m_frameTimesMs.size() * 1000.0 / m_totalMs;
+}
+
+static std::string escapeJson(const std::string& text)
+{
+	std::string output;
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') output += '\\';
+		if ((unsigned char)c < 0x20) continue;
+		output += c;
+	}
+	return output;
+}
+
+std::string FrameStats::ToJson(const std::string& mode, int width, int height, const std::string& renderer) const
+{
+	std::ostringstream json;
+	json.precision(4);
+	json << std::fixed;
+	json << "{\n";
+	json << "  \"mode\": \"" << escapeJson(mode) << "\",\n";
+	json << "  \"renderer\": \"" << escapeJson(renderer) << "\",\n";
+	json << "  \"width\": " << width << ",\n";
+	json << "  \"height\": " << height << ",\n";
+	json << "  \"startupMs\": " << m_startupMs << ",\n";
+	json << "  \"frames\": " << m_frameTimesMs.size() << ",\n";
+	json << "  \"totalMs\": " << m_totalMs << ",\n";
+	json << "  \"frameTimeMs\": {\n";
+	json << "    \"min\": " << GetMinMs() << ",\n";
+	json << "    \"avg\": " << GetAverageMs() << ",\n";
+	json << "    \"p99\": " << GetPercentileMs(99.0) << ",\n";
+	json << "    \"max\": " << GetMaxMs() << "\n";
+	json << "  },\n";
+	json << "  \"fps\": " << GetFramesPerSecond() << "\n";
+	json << "}\n";
+
+	return json.str();
+}
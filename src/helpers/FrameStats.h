@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Collects per-frame durations and summarizes them (min/avg/p99/fps) for the benchmark report
+class FrameStats
+{
+public:
+	FrameStats();
+	~FrameStats();
+
+	void AddFrame(double frameTimeMs);
+	void Clear();
+	// Time from a ready context to the end of the first frame (scene setup, shader builds)
+	inline void setStartupMs(double startupMs) { m_startupMs = startupMs; }
+
+	double GetMinMs() const;
+	double GetMaxMs() const;
+	double GetAverageMs() const;
+	double GetPercentileMs(double percentile) const;
+	double GetFramesPerSecond() const;
+
+	std::string ToJson(const std::string& mode, int width, int height, const std::string& renderer) const;
+
+	inline size_t getFrameCount() const { return m_frameTimesMs.size(); }
+	inline double getTotalMs() const { return m_totalMs; }
+	inline double getStartupMs() const { return m_startupMs; }
+private:
+	std::vector<double> m_frameTimesMs;
+	double m_totalMs = 0.0;
+	double m_startupMs = 0.0;
+};
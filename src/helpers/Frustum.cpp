@@ -0,0 +1,43 @@
+#include "Frustum.h"
+
+Frustum::Frustum()
+	: Frustum(glm::mat4(1.0f))
+{
+}
+
+Frustum::Frustum(const glm::mat4& clipMatrix)
+{
+	// A point is inside when -w <= x, y, z <= w in clip space, each side is a row combination of the matrix
+	glm::vec4 rowX = glm::vec4(clipMatrix[0][0], clipMatrix[1][0], clipMatrix[2][0], clipMatrix[3][0]);
+	glm::vec4 rowY = glm::vec4(clipMatrix[0][1], clipMatrix[1][1], clipMatrix[2][1], clipMatrix[3][1]);
+	glm::vec4 rowZ = glm::vec4(clipMatrix[0][2], clipMatrix[1][2], clipMatrix[2][2], clipMatrix[3][2]);
+	glm::vec4 rowW = glm::vec4(clipMatrix[0][3], clipMatrix[1][3], clipMatrix[2][3], clipMatrix[3][3]);
+
+	m_planes[0] = rowW + rowX; // left
+	m_planes[1] = rowW - rowX; // right
+	m_planes[2] = rowW + rowY; // bottom
+	m_planes[3] = rowW - rowY; // top
+	m_planes[4] = rowW + rowZ; // near
+	m_planes[5] = rowW - rowZ; // far
+}
+
+FrustumTest Frustum::Test(const BoundingBox& box) const
+{
+	if (box.isEmpty()) return FrustumTest::Outside;
+
+	FrustumTest result = FrustumTest::Inside;
+	for (const glm::vec4& plane : m_planes)
+	{
+		// Corner furthest along the plane normal, then the one furthest against it
+		glm::vec3 positive = glm::vec3(plane.x >= 0.0f ? box.max.x : box.min.x,
+			plane.y >= 0.0f ? box.max.y : box.min.y,
+			plane.z >= 0.0f ? box.max.z : box.min.z);
+		if (glm::dot(plane, glm::vec4(positive, 1.0f)) < 0.0f) return FrustumTest::Outside;
+
+		glm::vec3 negative = glm::vec3(plane.x >= 0.0f ? box.min.x : box.max.x,
+			plane.y >= 0.0f ? box.min.y : box.max.y,
+			plane.z >= 0.0f ? box.min.z : box.max.z);
+		if (glm::dot(plane, glm::vec4(negative, 1.0f)) < 0.0f) result = FrustumTest::Intersecting;
+	}
+	return result;
+}
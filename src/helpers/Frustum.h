@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Axis aligned box, empty until the first point is added
+struct BoundingBox
+{
+	glm::vec3 min = glm::vec3(1.0f);
+	glm::vec3 max = glm::vec3(-1.0f);
+
+	inline bool isEmpty() const { return min.x > max.x; }
+	inline glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+	inline glm::vec3 getExtent() const { return max - min; }
+
+	inline void Add(const glm::vec3& point)
+	{
+		min = isEmpty() ? point : glm::min(min, point);
+		max = isEmpty() ? point : glm::max(max, point);
+	}
+	inline void Add(const BoundingBox& box)
+	{
+		if (box.isEmpty()) return;
+		Add(box.min);
+		Add(box.max);
+	}
+};
+
+enum class FrustumTest
+{
+	Outside,
+	Intersecting,
+	Inside,
+};
+
+// Six clip planes pulled out of a view-projection (or model-view-projection) matrix.
+// Boxes are tested in the space the matrix takes to clip space, e.g. the object space of an MVP.
+class Frustum
+{
+public:
+	Frustum();
+	explicit Frustum(const glm::mat4& clipMatrix);
+
+	FrustumTest Test(const BoundingBox& box) const;
+	inline bool IsVisible(const BoundingBox& box) const { return Test(box) != FrustumTest::Outside; }
+private:
+	// xyz normal pointing inside, w distance, not normalized since only the sign is used
+	glm::vec4 m_planes[6];
+};
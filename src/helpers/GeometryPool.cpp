@@ -0,0 +1,248 @@
+#include "GeometryPool.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/glm.hpp>
+
+GeometryPool::GeometryPool(VertexFormat format, GLenum indexType, unsigned int vertexCapacity, unsigned int indexCapacity)
+	: m_format(format), m_indexType(indexType), m_vertexStride(GetVertexStride(format)),
+	m_indexSize(indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t)),
+	m_vertexCapacity(std::max(1u, vertexCapacity)), m_indexCapacity(std::max(1u, indexCapacity)),
+	m_indirectStream(initialCommandCapacity * sizeof(DrawElementsIndirectCommand), sizeof(DrawElementsIndirectCommand))
+{
+	m_multiDrawIndirect = GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+	m_baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+
+	glGenVertexArrays(1, &m_vao);
+	glGenBuffers(1, &m_vertexBuffer);
+	glGenBuffers(1, &m_indexBuffer);
+
+	glBindVertexArray(m_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_vertexCapacity * m_vertexStride, nullptr, GL_STATIC_DRAW);
+	SetupAttributes();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indexCapacity * m_indexSize, nullptr, GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	m_freeVertices.push_back({ 0, m_vertexCapacity });
+	m_freeIndices.push_back({ 0, m_indexCapacity });
+}
+
+GeometryPool::~GeometryPool()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(1, &m_vertexBuffer);
+	glDeleteBuffers(1, &m_indexBuffer);
+}
+
+void GeometryPool::SetupAttributes()
+{
+	// The VAO has to be bound, attributes 0 and 1 read the pool's vertex buffer
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	SetupVertexAttributes(m_format);
+}
+
+int GeometryPool::AddMesh(const void* vertexData, unsigned int vertexCount, const void* indexData, unsigned int indexCount)
+{
+	Mesh mesh;
+	mesh.vertices.count = vertexCount;
+	mesh.indices.count = indexCount;
+	mesh.used = true;
+
+	if (!Allocate(m_freeVertices, vertexCount, mesh.vertices.first))
+	{
+		Grow(m_vertexBuffer, m_vertexCapacity, m_freeVertices, vertexCount, m_vertexStride, GL_ARRAY_BUFFER);
+		if (!Allocate(m_freeVertices, vertexCount, mesh.vertices.first)) return -1;
+	}
+	if (!Allocate(m_freeIndices, indexCount, mesh.indices.first))
+	{
+		Grow(m_indexBuffer, m_indexCapacity, m_freeIndices, indexCount, m_indexSize, GL_ELEMENT_ARRAY_BUFFER);
+		if (!Allocate(m_freeIndices, indexCount, mesh.indices.first))
+		{
+			Free(m_freeVertices, mesh.vertices);
+			return -1;
+		}
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, mesh.vertices.first * m_vertexStride, vertexCount * m_vertexStride, vertexData);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	// Through the copy target so the element binding of whatever VAO is bound stays untouched
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, mesh.indices.first * m_indexSize, indexCount * m_indexSize, indexData);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	// Ids of removed meshes are handed out again
+	m_meshCount++;
+	for (size_t i = 0; i < m_meshes.size(); i++)
+	{
+		if (!m_meshes[i].used)
+		{
+			m_meshes[i] = mesh;
+			return (int)i;
+		}
+	}
+	m_meshes.push_back(mesh);
+	return (int)m_meshes.size() - 1;
+}
+
+void GeometryPool::RemoveMesh(int meshId)
+{
+	if (meshId < 0 || meshId >= (int)m_meshes.size() || !m_meshes[meshId].used) return;
+
+	Mesh& mesh = m_meshes[meshId];
+	Free(m_freeVertices, mesh.vertices);
+	Free(m_freeIndices, mesh.indices);
+	mesh.used = false;
+	m_meshCount--;
+}
+
+DrawElementsIndirectCommand GeometryPool::GetDrawCommand(int meshId, unsigned int instanceCount, unsigned int baseInstance) const
+{
+	const Mesh& mesh = m_meshes[meshId];
+	DrawElementsIndirectCommand command;
+	command.count = mesh.indices.count;
+	command.instanceCount = instanceCount;
+	command.firstIndex = mesh.indices.first;
+	command.baseVertex = (GLint)mesh.vertices.first;
+	command.baseInstance = baseInstance;
+	return command;
+}
+
+void GeometryPool::SetInstanceBuffer(unsigned int buffer)
+{
+	m_instanceBuffer = buffer;
+	glBindVertexArray(m_vao);
+	SetInstanceAttributes(0);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void GeometryPool::SetInstanceAttributes(unsigned int firstMatrix)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+
+	// A mat4 attribute is four vec4 columns, each advancing once per instance
+	for (int column = 0; column < 4; column++)
+	{
+		size_t offset = ((size_t)firstMatrix * 4 + column) * sizeof(glm::vec4);
+		glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+		glEnableVertexAttribArray(2 + column);
+		glVertexAttribDivisor(2 + column, 1);
+	}
+}
+
+void GeometryPool::Draw(const std::vector<DrawElementsIndirectCommand>& commands)
+{
+	m_submissionCount = 0;
+	if (commands.empty()) return;
+
+	glBindVertexArray(m_vao);
+
+	if (isUsingMultiDrawIndirect())
+	{
+		// Written into the next segment of the ring, the culled command list changes every frame anyway
+		size_t commandBytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+		std::memcpy(m_indirectStream.Begin(commandBytes), commands.data(), commandBytes);
+		m_indirectStream.End();
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectStream.getBuffer());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, m_indexType, (void*)m_indirectStream.getOffset(), (GLsizei)commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		m_indirectStream.Fence();
+		m_submissionCount = 1;
+		return;
+	}
+
+	// Same commands one by one, without base instance support the instance attributes are moved instead
+	for (const DrawElementsIndirectCommand& command : commands)
+	{
+		if (command.instanceCount == 0) continue;
+		void* firstIndex = (void*)((size_t)command.firstIndex * m_indexSize);
+
+		if (m_baseInstance)
+		{
+			glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, m_indexType, firstIndex,
+				command.instanceCount, command.baseVertex, command.baseInstance);
+		}
+		else
+		{
+			if (m_instanceBuffer) SetInstanceAttributes(command.baseInstance);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, m_indexType, firstIndex,
+				command.instanceCount, command.baseVertex);
+		}
+		m_submissionCount++;
+	}
+
+	if (!m_baseInstance && m_instanceBuffer) SetInstanceAttributes(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool GeometryPool::Allocate(std::vector<Range>& freeRanges, unsigned int count, unsigned int& first)
+{
+	for (size_t i = 0; i < freeRanges.size(); i++)
+	{
+		if (freeRanges[i].count < count) continue;
+
+		first = freeRanges[i].first;
+		freeRanges[i].first += count;
+		freeRanges[i].count -= count;
+		if (freeRanges[i].count == 0) freeRanges.erase(freeRanges.begin() + i);
+		return true;
+	}
+	return false;
+}
+
+void GeometryPool::Free(std::vector<Range>& freeRanges, const Range& range)
+{
+	if (range.count == 0) return;
+
+	// Kept sorted by start, so only the neighbours on either side can touch the new range
+	auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), range,
+		[](const Range& a, const Range& b) { return a.first < b.first; });
+	next = freeRanges.insert(next, range);
+
+	if (next + 1 != freeRanges.end() && next->first + next->count == (next + 1)->first)
+	{
+		next->count += (next + 1)->count;
+		freeRanges.erase(next + 1);
+	}
+	if (next != freeRanges.begin() && (next - 1)->first + (next - 1)->count == next->first)
+	{
+		(next - 1)->count += next->count;
+		freeRanges.erase(next);
+	}
+}
+
+void GeometryPool::Grow(unsigned int& buffer, unsigned int& capacity, std::vector<Range>& freeRanges, unsigned int needed,
+	size_t elementSize, GLenum target)
+{
+	// Doubles at least, so a pool filled mesh by mesh grows a logarithmic number of times
+	unsigned int newCapacity = std::max(capacity * 2, capacity + needed);
+
+	unsigned int newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, (size_t)newCapacity * elementSize, nullptr, GL_STATIC_DRAW);
+	glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)capacity * elementSize);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glDeleteBuffers(1, &buffer);
+
+	Free(freeRanges, { capacity, newCapacity - capacity });
+	buffer = newBuffer;
+	capacity = newCapacity;
+
+	// Point the VAO at the new storage
+	glBindVertexArray(m_vao);
+	if (target == GL_ARRAY_BUFFER) SetupAttributes();
+	else glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glew.h>
+
+#include "StreamBuffer.h"
+#include "VertexFormat.h"
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must match the GL layout");
+
+// Every mesh of one vertex format suballocated from a single vertex buffer and a single index buffer behind one VAO.
+// Indices stay relative to their mesh (the draw adds the base vertex), so 16-bit pools hold meshes of up to 65536 vertices each.
+// Draws are a list of indirect commands submitted with one glMultiDrawElementsIndirect, or a loop of
+// base vertex draws on contexts without GL 4.3. Needs a current OpenGL context.
+class GeometryPool
+{
+public:
+	GeometryPool(VertexFormat format, GLenum indexType, unsigned int vertexCapacity, unsigned int indexCapacity);
+	~GeometryPool();
+
+	GeometryPool(const GeometryPool&) = delete;
+	GeometryPool& operator=(const GeometryPool&) = delete;
+
+	// Copies the mesh into free ranges of the buffers (growing them when full) and returns its id.
+	// vertexData is in the pool's format, indexData in its index type.
+	int AddMesh(const void* vertexData, unsigned int vertexCount, const void* indexData, unsigned int indexCount);
+	// Its ranges are reused by later meshes, no GL object is created or deleted
+	void RemoveMesh(int meshId);
+
+	// Command drawing the whole mesh, instances read matrices from baseInstance on in the instance buffer
+	DrawElementsIndirectCommand GetDrawCommand(int meshId, unsigned int instanceCount = 1, unsigned int baseInstance = 0) const;
+	// Per-instance mat4 for attributes 2 to 5, optional
+	void SetInstanceBuffer(unsigned int buffer);
+
+	// Binds the VAO and submits every command, the program has to be bound already
+	void Draw(const std::vector<DrawElementsIndirectCommand>& commands);
+
+	inline VertexFormat getVertexFormat() const { return m_format; }
+	inline GLenum getIndexType() const { return m_indexType; }
+	inline bool hasMultiDrawIndirect() const { return m_multiDrawIndirect; }
+	// Lets the loop be compared with the indirect path, no effect without GL 4.3
+	inline void setUseMultiDrawIndirect(bool use) { m_useMultiDrawIndirect = use; }
+	inline bool isUsingMultiDrawIndirect() const { return m_multiDrawIndirect && m_useMultiDrawIndirect; }
+	inline unsigned int getMeshCount() const { return m_meshCount; }
+	inline unsigned int getVertexCapacity() const { return m_vertexCapacity; }
+	inline unsigned int getIndexCapacity() const { return m_indexCapacity; }
+	inline unsigned int getSubmissionCount() const { return m_submissionCount; }
+	inline unsigned int getInstanceBuffer() const { return m_instanceBuffer; }
+	inline const StreamBuffer& getIndirectStream() const { return m_indirectStream; }
+
+	static const unsigned int initialCommandCapacity = 64;
+private:
+	struct Range
+	{
+		unsigned int first = 0;
+		unsigned int count = 0;
+	};
+
+	struct Mesh
+	{
+		Range vertices;
+		Range indices;
+		bool used;
+	};
+
+	// First fit, false when no free range is large enough
+	static bool Allocate(std::vector<Range>& freeRanges, unsigned int count, unsigned int& first);
+	// Puts the range back and merges it with its neighbours
+	static void Free(std::vector<Range>& freeRanges, const Range& range);
+	// New storage of at least "needed" elements, the old content is copied over on the GPU
+	void Grow(unsigned int& buffer, unsigned int& capacity, std::vector<Range>& freeRanges, unsigned int needed,
+		size_t elementSize, GLenum target);
+	void SetupAttributes();
+	void SetInstanceAttributes(unsigned int firstMatrix);
+
+	VertexFormat m_format;
+	GLenum m_indexType;
+	size_t m_vertexStride;
+	size_t m_indexSize;
+
+	unsigned int m_vao = 0;
+	unsigned int m_vertexBuffer = 0, m_indexBuffer = 0;
+	unsigned int m_instanceBuffer = 0;
+	unsigned int m_vertexCapacity = 0, m_indexCapacity = 0;
+	StreamBuffer m_indirectStream;
+	std::vector<Range> m_freeVertices, m_freeIndices;
+
+	std::vector<Mesh> m_meshes;
+	unsigned int m_meshCount = 0;
+
+	bool m_multiDrawIndirect = false;
+	bool m_baseInstance = false;
+	bool m_useMultiDrawIndirect = true;
+	unsigned int m_submissionCount = 0;
+};
@@ -0,0 +1,229 @@
+#include "HeadlessContext.h"
+
+#include <glew.h>
+#include <GLFW/glfw3.h>
+
+#ifndef _WIN32
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext(int width, int height)
+	: m_width(width), m_height(height)
+{
+	if (!CreateContext()) return;
+
+	// Add GLEW for OpenGL access
+	glewExperimental = GL_TRUE;
+#ifdef _WIN32
+	GLenum glewInitialize = glewInit();
+#else
+	// glewInit() also looks for a GLX display, which a headless box does not have
+	GLenum glewInitialize = glewContextInit();
+#endif
+	if (glewInitialize != GLEW_OK) {
+		m_error = std::string("Error glewInit: ") + (const char*)glewGetErrorString(glewInitialize);
+		return;
+	}
+
+	if (!CreateFramebuffer()) return;
+
+	m_valid = true;
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (m_framebuffer) glDeleteFramebuffers(1, &m_framebuffer);
+	if (m_colorRenderbuffer) glDeleteRenderbuffers(1, &m_colorRenderbuffer);
+	if (m_depthRenderbuffer) glDeleteRenderbuffers(1, &m_depthRenderbuffer);
+
+	DestroyContext();
+}
+
+void HeadlessContext::BindFramebuffer()
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(0, 0, m_width, m_height);
+}
+
+#ifdef _WIN32
+bool HeadlessContext::CreateContext()
+{
+	if (!glfwInit()) {
+		m_error = "GLFW could not initialize";
+		return false;
+	}
+
+	// Set OpenGL minumum version
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	m_window = glfwCreateWindow(m_width, m_height, "Matrices Visualizer (headless)", NULL, NULL);
+	if (!m_window) {
+		glfwTerminate();
+		m_error = "Hidden window could not initialize";
+		return false;
+	}
+
+	glfwMakeContextCurrent(m_window);
+	glfwSwapInterval(0);
+
+	return true;
+}
+
+bool HeadlessContext::CreateSharedContext()
+{
+	// The hints of the main window are still set
+	m_sharedWindow = glfwCreateWindow(1, 1, "Matrices Visualizer (worker)", NULL, m_window);
+	return m_sharedWindow != nullptr;
+}
+
+bool HeadlessContext::MakeSharedContextCurrent()
+{
+	if (!m_sharedWindow) return false;
+
+	glfwMakeContextCurrent(m_sharedWindow);
+	return true;
+}
+
+void HeadlessContext::ReleaseSharedContext()
+{
+	glfwMakeContextCurrent(NULL);
+}
+
+void HeadlessContext::DestroyContext()
+{
+	if (m_sharedWindow)
+	{
+		glfwDestroyWindow(m_sharedWindow);
+		m_sharedWindow = nullptr;
+	}
+	if (m_window)
+	{
+		glfwDestroyWindow(m_window);
+		glfwTerminate();
+		m_window = nullptr;
+	}
+}
+#else
+// Set OpenGL minumum version
+static const EGLint contextAttributes[] = {
+	EGL_CONTEXT_MAJOR_VERSION, 3,
+	EGL_CONTEXT_MINOR_VERSION, 3,
+	EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+	EGL_NONE
+};
+
+bool HeadlessContext::CreateContext()
+{
+	// Prefer Mesa's surfaceless platform, it needs neither X11 nor a DRM device
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (getPlatformDisplay) display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	if (display == EGL_NO_DISPLAY) display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	EGLint major = 0, minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+		m_error = "EGL display could not initialize";
+		return false;
+	}
+	m_display = display;
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+		m_error = "No EGL config with desktop OpenGL support";
+		return false;
+	}
+	m_config = config;
+
+	if (!eglBindAPI(EGL_OPENGL_API)) {
+		m_error = "EGL could not bind the OpenGL API";
+		return false;
+	}
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT) {
+		m_error = "EGL context could not initialize";
+		return false;
+	}
+	m_context = context;
+
+	// No surface at all, everything is drawn into our framebuffer object
+	if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+		m_error = "EGL context could not be made current";
+		return false;
+	}
+
+	return true;
+}
+
+bool HeadlessContext::CreateSharedContext()
+{
+	m_sharedContext = eglCreateContext((EGLDisplay)m_display, (EGLConfig)m_config, (EGLContext)m_context, contextAttributes);
+	if (m_sharedContext == EGL_NO_CONTEXT) m_sharedContext = nullptr;
+
+	return m_sharedContext != nullptr;
+}
+
+bool HeadlessContext::MakeSharedContextCurrent()
+{
+	if (!m_sharedContext) return false;
+
+	return eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, (EGLContext)m_sharedContext) == EGL_TRUE;
+}
+
+void HeadlessContext::ReleaseSharedContext()
+{
+	eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void HeadlessContext::DestroyContext()
+{
+	if (m_display)
+	{
+		eglMakeCurrent((EGLDisplay)m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_sharedContext) eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_sharedContext);
+		if (m_context) eglDestroyContext((EGLDisplay)m_display, (EGLContext)m_context);
+		eglTerminate((EGLDisplay)m_display);
+		m_sharedContext = nullptr;
+		m_context = nullptr;
+		m_display = nullptr;
+	}
+}
+#endif
+
+bool HeadlessContext::CreateFramebuffer()
+{
+	glGenFramebuffers(1, &m_framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+	glGenRenderbuffers(1, &m_colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorRenderbuffer);
+
+	glGenRenderbuffers(1, &m_depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, m_width, m_height);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthRenderbuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		m_error = "Offscreen framebuffer is incomplete";
+		return false;
+	}
+
+	glViewport(0, 0, m_width, m_height);
+
+	return true;
+}
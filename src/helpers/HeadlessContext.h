@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+
+struct GLFWwindow;
+
+// Offscreen OpenGL 3.3 core context rendering into its own framebuffer object.
+// On Linux the context comes from EGL (surfaceless, works on Mesa llvmpipe without a display or GPU),
+// on Windows from a hidden GLFW window.
+class HeadlessContext
+{
+public:
+	HeadlessContext(int width, int height);
+	~HeadlessContext();
+
+	void BindFramebuffer();
+
+	// Second context sharing objects with this one, for a worker thread (see ShaderCompileQueue).
+	// Created here on the render thread, made current and released on the worker.
+	bool CreateSharedContext();
+	bool MakeSharedContextCurrent();
+	void ReleaseSharedContext();
+
+	inline bool isValid() const { return m_valid; }
+	inline const std::string& getError() const { return m_error; }
+	inline int getWidth() const { return m_width; }
+	inline int getHeight() const { return m_height; }
+private:
+	bool CreateContext();
+	bool CreateFramebuffer();
+	void DestroyContext();
+
+	int m_width = 0;
+	int m_height = 0;
+	bool m_valid = false;
+	std::string m_error = "";
+
+#ifdef _WIN32
+	GLFWwindow* m_window = nullptr;
+	GLFWwindow* m_sharedWindow = nullptr;
+#else
+	void* m_display = nullptr; // EGLDisplay
+	void* m_config = nullptr; // EGLConfig
+	void* m_context = nullptr; // EGLContext
+	void* m_sharedContext = nullptr; // EGLContext
+#endif
+
+	unsigned int m_framebuffer = 0;
+	unsigned int m_colorRenderbuffer = 0;
+	unsigned int m_depthRenderbuffer = 0;
+};
@@ -0,0 +1,311 @@
+#include "InputRecording.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+
+static const char inputLogMagic[4] = { 'M', 'V', 'I', 'L' };
+static const uint32_t inputLogVersion = 1;
+static const uint8_t controlsFlag = 1;
+
+// Every recorded field of SceneControls in file order, the same list reads and writes them
+template <typename Controls, typename Visitor>
+static void visitControls(Controls& controls, Visitor&& visit)
+{
+	visit(controls.showPrism);
+	visit(controls.useInstancing);
+	visit(controls.instanceCount);
+	visit(controls.animateInstances);
+	visit(controls.showLoadedMesh);
+	visit(controls.frustumCulling);
+	visit(controls.multiDrawIndirect);
+	visit(controls.translateVector);
+	visit(controls.rotationXDegrees);
+	visit(controls.rotationYDegrees);
+	visit(controls.rotationZDegrees);
+	visit(controls.viewEye);
+	visit(controls.viewCenter);
+	visit(controls.viewUpDown);
+	visit(controls.orthoLeft);
+	visit(controls.orthoRight);
+	visit(controls.orthoBottom);
+	visit(controls.orthoTop);
+	visit(controls.fov);
+	visit(controls.showOrthoProjection);
+	visit(controls.useViewMatrix);
+	visit(controls.useProjectionMatrix);
+}
+
+static void appendBytes(std::string& buffer, const void* data, size_t size)
+{
+	buffer.append((const char*)data, size);
+}
+
+static void appendValue(std::string& buffer, bool value) { uint8_t byte = value ? 1 : 0; appendBytes(buffer, &byte, 1); }
+static void appendValue(std::string& buffer, int value) { int32_t word = value; appendBytes(buffer, &word, 4); }
+static void appendValue(std::string& buffer, float value) { appendBytes(buffer, &value, 4); }
+static void appendValue(std::string& buffer, const glm::vec3& value) { appendBytes(buffer, &value[0], 12); }
+
+// Reads from an in-memory log, every read past the end fails and leaves the value alone
+class LogReader
+{
+public:
+	LogReader(const std::vector<char>& data, size_t offset) : m_data(data), m_offset(offset) {}
+
+	bool ReadBytes(void* out, size_t size)
+	{
+		if (m_offset + size > m_data.size())
+		{
+			m_valid = false;
+			return false;
+		}
+		std::memcpy(out, m_data.data() + m_offset, size);
+		m_offset += size;
+		return true;
+	}
+	void Read(bool& value) { uint8_t byte = 0; if (ReadBytes(&byte, 1)) value = byte != 0; }
+	void Read(int& value) { int32_t word = 0; if (ReadBytes(&word, 4)) value = word; }
+	void Read(float& value) { ReadBytes(&value, 4); }
+	void Read(glm::vec3& value) { ReadBytes(&value[0], 12); }
+
+	inline bool isValid() const { return m_valid; }
+private:
+	const std::vector<char>& m_data;
+	size_t m_offset;
+	bool m_valid = true;
+};
+
+InputRecorder::InputRecorder()
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+	std::string error;
+	Stop(error);
+}
+
+bool InputRecorder::Start(const std::string& filePath, std::string& error)
+{
+	if (!Stop(error)) return false;
+
+	m_file.open(filePath, std::ios::binary | std::ios::trunc);
+	if (!m_file) {
+		error = "Could not open " + filePath;
+		return false;
+	}
+
+	InputLogHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, inputLogMagic, 4);
+	header.version = inputLogVersion;
+	m_file.write((const char*)&header, sizeof(header));
+
+	m_filePath = filePath;
+	m_events.clear();
+	m_lastControls.clear();
+	m_frameCount = 0;
+	m_byteCount = sizeof(header);
+	return true;
+}
+
+bool InputRecorder::Stop(std::string& error)
+{
+	if (!m_file.is_open()) return true;
+
+	m_file.seekp(offsetof(InputLogHeader, frameCount));
+	uint32_t frameCount = m_frameCount;
+	m_file.write((const char*)&frameCount, sizeof(frameCount));
+	m_file.close();
+
+	if (!m_file) {
+		error = "Could not write " + m_filePath;
+		return false;
+	}
+	return true;
+}
+
+void InputRecorder::AddEvent(const InputEvent& event)
+{
+	if (isRecording()) m_events.push_back(event);
+}
+
+void InputRecorder::RecordFrame(const SceneControls& controls, float aspectRatio)
+{
+	if (!isRecording()) return;
+
+	std::string controlBytes;
+	visitControls(controls, [&controlBytes](const auto& value) { appendValue(controlBytes, value); });
+	bool controlsChanged = controlBytes != m_lastControls;
+
+	std::string frame;
+	uint8_t flags = controlsChanged ? controlsFlag : 0;
+	uint32_t eventCount = (uint32_t)m_events.size();
+	appendBytes(frame, &flags, 1);
+	appendValue(frame, aspectRatio);
+	appendBytes(frame, &eventCount, 4);
+	if (controlsChanged) frame += controlBytes;
+
+	// Only the fields the type uses, most events fit in a few bytes
+	for (const InputEvent& event : m_events)
+	{
+		uint8_t type = (uint8_t)event.type;
+		appendBytes(frame, &type, 1);
+		switch (event.type)
+		{
+		case InputEventType::MouseButton:
+		{
+			uint8_t fields[3] = { (uint8_t)event.a, (uint8_t)event.b, (uint8_t)event.c };
+			appendBytes(frame, fields, 3);
+			break;
+		}
+		case InputEventType::Key:
+		{
+			int32_t fields[2] = { event.a, event.b };
+			uint8_t actionAndMods[2] = { (uint8_t)event.c, (uint8_t)event.d };
+			appendBytes(frame, fields, 8);
+			appendBytes(frame, actionAndMods, 2);
+			break;
+		}
+		case InputEventType::Char:
+			appendBytes(frame, &event.a, 4);
+			break;
+		case InputEventType::FramebufferSize:
+			appendBytes(frame, &event.a, 4);
+			appendBytes(frame, &event.b, 4);
+			break;
+		case InputEventType::Scroll:
+		case InputEventType::CursorPos:
+			appendValue(frame, event.x);
+			appendValue(frame, event.y);
+			break;
+		}
+	}
+
+	m_file.write(frame.data(), frame.size());
+	m_byteCount += frame.size();
+	m_frameCount++;
+	m_events.clear();
+	if (controlsChanged) m_lastControls.swap(controlBytes);
+}
+
+bool InputReplay::Load(const std::string& filePath, std::string& error)
+{
+	m_frames.clear();
+	m_eventCount = 0;
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file) {
+		error = "Could not open " + filePath;
+		return false;
+	}
+	std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	InputLogHeader header;
+	if (data.size() < sizeof(header)) {
+		error = "file too small for an input log header: " + filePath;
+		return false;
+	}
+	std::memcpy(&header, data.data(), sizeof(header));
+	if (std::memcmp(header.magic, inputLogMagic, 4) != 0 || header.version != inputLogVersion) {
+		error = "not a version " + std::to_string(inputLogVersion) + " input log: " + filePath;
+		return false;
+	}
+
+	// Frames without a controls block repeat the previous ones, the first frame always has one
+	LogReader reader(data, sizeof(header));
+	SceneControls controls;
+	bool haveControls = false;
+	// A frame takes at least 9 bytes, a corrupt count must not reserve gigabytes
+	m_frames.reserve(std::min<size_t>(header.frameCount, data.size() / 9));
+	while (m_frames.size() < header.frameCount && reader.isValid())
+	{
+		InputFrame frame;
+		uint8_t flags = 0;
+		uint32_t eventCount = 0;
+		reader.ReadBytes(&flags, 1);
+		reader.Read(frame.aspectRatio);
+		reader.ReadBytes(&eventCount, 4);
+		if (flags & controlsFlag)
+		{
+			visitControls(controls, [&reader](auto& value) { reader.Read(value); });
+			haveControls = true;
+		}
+		if (!haveControls) {
+			error = "first frame without controls: " + filePath;
+			m_frames.clear();
+			return false;
+		}
+		frame.controls = controls;
+
+		for (uint32_t i = 0; i < eventCount && reader.isValid(); i++)
+		{
+			InputEvent event;
+			uint8_t type = 0;
+			reader.ReadBytes(&type, 1);
+			event.type = (InputEventType)type;
+			switch (event.type)
+			{
+			case InputEventType::MouseButton:
+			{
+				uint8_t fields[3] = { 0, 0, 0 };
+				reader.ReadBytes(fields, 3);
+				event.a = fields[0];
+				event.b = fields[1];
+				event.c = fields[2];
+				break;
+			}
+			case InputEventType::Key:
+			{
+				uint8_t actionAndMods[2] = { 0, 0 };
+				reader.ReadBytes(&event.a, 4);
+				reader.ReadBytes(&event.b, 4);
+				reader.ReadBytes(actionAndMods, 2);
+				event.c = actionAndMods[0];
+				event.d = actionAndMods[1];
+				break;
+			}
+			case InputEventType::Char:
+				reader.ReadBytes(&event.a, 4);
+				break;
+			case InputEventType::FramebufferSize:
+				reader.ReadBytes(&event.a, 4);
+				reader.ReadBytes(&event.b, 4);
+				break;
+			case InputEventType::Scroll:
+			case InputEventType::CursorPos:
+				reader.Read(event.x);
+				reader.Read(event.y);
+				break;
+			default:
+				error = "unknown event type " + std::to_string(type) + ": " + filePath;
+				m_frames.clear();
+				return false;
+			}
+			frame.events.push_back(event);
+		}
+
+		m_eventCount += frame.events.size();
+		m_frames.push_back(frame);
+	}
+
+	if (!reader.isValid() || m_frames.size() != header.frameCount) {
+		error = "truncated input log: " + filePath;
+		m_frames.clear();
+		return false;
+	}
+	return true;
+}
+
+uint32_t MatrixChecksum(const glm::mat4& matrix)
+{
+	const unsigned char* bytes = (const unsigned char*)&matrix[0][0];
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < sizeof(glm::mat4); i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
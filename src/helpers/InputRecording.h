@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "SceneControls.h"
+
+// Input log (.mvinput), little endian:
+//   InputLogHeader | frame | frame | ...
+// Each frame: uint8 flags, float aspect ratio, uint32 event count, the SceneControls fields when flag 1 is set
+// (only written when they changed since the previous frame), then the events as a type byte and its payload.
+struct InputLogHeader
+{
+	char magic[4];          // "MVIL"
+	uint32_t version;
+	uint32_t frameCount;    // written when the recording stops
+	uint32_t reserved;
+};
+static_assert(sizeof(InputLogHeader) == 16, "InputLogHeader is written to disk as is");
+
+enum class InputEventType : uint8_t
+{
+	MouseButton,    // a = button, b = action, c = mods
+	Scroll,         // x, y offsets
+	Key,            // a = key, b = scancode, c = action, d = mods
+	Char,           // a = codepoint
+	CursorPos,      // x, y in window coordinates
+	FramebufferSize // a = width, b = height
+};
+
+// One GLFW input callback
+struct InputEvent
+{
+	InputEventType type = InputEventType::MouseButton;
+	int32_t a = 0, b = 0, c = 0, d = 0;
+	float x = 0.0f, y = 0.0f;
+};
+
+struct InputFrame
+{
+	SceneControls controls;
+	float aspectRatio = 1.0f;
+	std::vector<InputEvent> events;
+};
+
+// Writes one frame per Scene::Draw: the controls it drew with, and the input that arrived since the previous frame.
+// The matrices only depend on the controls and the aspect ratio, so replaying those reproduces them exactly.
+class InputRecorder
+{
+public:
+	InputRecorder();
+	~InputRecorder();
+
+	bool Start(const std::string& filePath, std::string& error);
+	// Patches the frame count into the header and closes the file, also done by the destructor
+	bool Stop(std::string& error);
+
+	// Kept until the next RecordFrame
+	void AddEvent(const InputEvent& event);
+	void RecordFrame(const SceneControls& controls, float aspectRatio);
+
+	inline bool isRecording() const { return m_file.is_open(); }
+	inline unsigned int getFrameCount() const { return m_frameCount; }
+	inline unsigned long long getByteCount() const { return m_byteCount; }
+private:
+	std::ofstream m_file;
+	std::string m_filePath = "";
+	std::vector<InputEvent> m_events;
+	// Serialized controls of the last written frame, frames with the same bytes skip them
+	std::string m_lastControls = "";
+	unsigned int m_frameCount = 0;
+	unsigned long long m_byteCount = 0;
+};
+
+// Whole log read into memory, frames are tiny
+class InputReplay
+{
+public:
+	bool Load(const std::string& filePath, std::string& error);
+
+	inline size_t getFrameCount() const { return m_frames.size(); }
+	inline const InputFrame& getFrame(size_t frame) const { return m_frames[frame]; }
+	inline size_t getEventCount() const { return m_eventCount; }
+private:
+	std::vector<InputFrame> m_frames;
+	size_t m_eventCount = 0;
+};
+
+// FNV-1a over the matrix bytes, replays of the same log print the same values frame by frame
+uint32_t MatrixChecksum(const glm::mat4& matrix);
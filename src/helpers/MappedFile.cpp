@@ -0,0 +1,115 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		m_error = "file opening failed: " + filePath;
+		return false;
+	}
+	m_fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		m_error = "empty or unreadable file: " + filePath;
+		Close();
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (!mapping) {
+		m_error = "file mapping failed: " + filePath;
+		Close();
+		return false;
+	}
+	m_mappingHandle = mapping;
+
+	m_data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data) {
+		m_error = "file mapping failed: " + filePath;
+		Close();
+		return false;
+	}
+	m_size = (size_t)fileSize.QuadPart;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data) UnmapViewOfFile(m_data);
+	if (m_mappingHandle) CloseHandle((HANDLE)m_mappingHandle);
+	if (m_fileHandle) CloseHandle((HANDLE)m_fileHandle);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_mappingHandle = nullptr;
+	m_fileHandle = nullptr;
+}
+#else
+bool MappedFile::Open(const std::string& filePath)
+{
+	Close();
+
+	m_fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (m_fileDescriptor < 0) {
+		m_error = "file opening failed: " + filePath;
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(m_fileDescriptor, &fileStat) != 0 || fileStat.st_size == 0) {
+		m_error = "empty or unreadable file: " + filePath;
+		Close();
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, m_fileDescriptor, 0);
+	if (data == MAP_FAILED) {
+		m_error = "file mapping failed: " + filePath;
+		Close();
+		return false;
+	}
+
+	// Meshes are read front to back once, let the kernel read ahead aggressively
+	madvise(data, (size_t)fileStat.st_size, MADV_SEQUENTIAL);
+
+	m_data = (const unsigned char*)data;
+	m_size = (size_t)fileStat.st_size;
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (m_data) munmap((void*)m_data, m_size);
+	if (m_fileDescriptor >= 0) close(m_fileDescriptor);
+
+	m_data = nullptr;
+	m_size = 0;
+	m_fileDescriptor = -1;
+}
+#endif
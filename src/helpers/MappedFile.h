@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (mmap on POSIX, MapViewOfFile on Windows).
+// The data is paged in by the OS on first access, nothing is copied into process memory.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	inline bool isOpen() const { return m_data != nullptr; }
+	inline const unsigned char* getData() const { return m_data; }
+	inline size_t getSize() const { return m_size; }
+	inline const std::string& getError() const { return m_error; }
+private:
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	std::string m_error = "";
+
+#ifdef _WIN32
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#else
+	int m_fileDescriptor = -1;
+#endif
+};
@@ -0,0 +1,123 @@
+#include "MatrixCache.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static const glm::vec3 rotationXAxis = glm::vec3(1.0f, 0.0f, 0.0f);
+static const glm::vec3 rotationYAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+static const glm::vec3 rotationZAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+
+MatrixCache::MatrixCache()
+{
+}
+
+MatrixCache::~MatrixCache()
+{
+}
+
+bool MatrixCache::SameInputs(const ModelInputs& a, const ModelInputs& b)
+{
+	return a.translateVector == b.translateVector &&
+		a.rotationXDegrees == b.rotationXDegrees &&
+		a.rotationYDegrees == b.rotationYDegrees &&
+		a.rotationZDegrees == b.rotationZDegrees;
+}
+
+bool MatrixCache::SameInputs(const ViewInputs& a, const ViewInputs& b)
+{
+	// Without the view matrix the other values do not matter
+	if (a.useViewMatrix != b.useViewMatrix) return false;
+	if (!a.useViewMatrix) return true;
+
+	return a.viewEye == b.viewEye && a.viewCenter == b.viewCenter && a.viewUpDown == b.viewUpDown;
+}
+
+bool MatrixCache::SameInputs(const ProjectionInputs& a, const ProjectionInputs& b)
+{
+	if (a.useProjectionMatrix != b.useProjectionMatrix) return false;
+	if (!a.useProjectionMatrix) return true;
+	if (a.showOrthoProjection != b.showOrthoProjection) return false;
+
+	if (a.showOrthoProjection)
+	{
+		return a.orthoLeft == b.orthoLeft && a.orthoRight == b.orthoRight &&
+			a.orthoBottom == b.orthoBottom && a.orthoTop == b.orthoTop;
+	}
+
+	return a.fov == b.fov && a.aspectRatio == b.aspectRatio;
+}
+
+bool MatrixCache::Update(const SceneControls& controls, float aspectRatio)
+{
+	ModelInputs modelInputs = {
+		controls.translateVector,
+		controls.rotationXDegrees, controls.rotationYDegrees, controls.rotationZDegrees
+	};
+	ViewInputs viewInputs = {
+		controls.useViewMatrix,
+		controls.viewEye, controls.viewCenter, controls.viewUpDown
+	};
+	ProjectionInputs projectionInputs = {
+		controls.useProjectionMatrix,
+		controls.showOrthoProjection,
+		controls.orthoLeft, controls.orthoRight, controls.orthoBottom, controls.orthoTop,
+		controls.fov,
+		aspectRatio
+	};
+
+	bool modelChanged = !m_valid || !SameInputs(modelInputs, m_modelInputs);
+	bool viewChanged = !m_valid || !SameInputs(viewInputs, m_viewInputs);
+	bool projectionChanged = !m_valid || !SameInputs(projectionInputs, m_projectionInputs);
+	m_valid = true;
+
+	if (modelChanged)
+	{
+		glm::mat4 rotationMatrix = glm::mat4(1.0f);
+		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(controls.rotationXDegrees), rotationXAxis);
+		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(controls.rotationYDegrees), rotationYAxis);
+		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(controls.rotationZDegrees), rotationZAxis);
+		glm::mat4 translateMatrix = glm::translate(glm::mat4(1.0f), controls.translateVector);
+		m_modelMatrix = translateMatrix * rotationMatrix;
+
+		m_modelInputs = modelInputs;
+		m_modelUpdateCount++;
+	}
+
+	if (viewChanged)
+	{
+		m_viewMatrix = glm::mat4(1.0f);
+		if (controls.useViewMatrix)
+		{
+			m_viewMatrix = glm::lookAt(
+				controls.viewEye, // eye
+				controls.viewCenter, // center
+				controls.viewUpDown // up/down - use y only?
+			);
+		}
+
+		m_viewInputs = viewInputs;
+		m_viewUpdateCount++;
+	}
+
+	if (projectionChanged)
+	{
+		m_projectionMatrix = glm::mat4(1.0f);
+		if (controls.useProjectionMatrix)
+		{
+			if (controls.showOrthoProjection)
+				m_projectionMatrix = glm::ortho(controls.orthoLeft, controls.orthoRight, controls.orthoBottom, controls.orthoTop, 0.1f, 100.0f);
+			else
+				m_projectionMatrix = glm::perspective(glm::radians(controls.fov), aspectRatio, 0.1f, 100.0f);
+		}
+
+		m_projectionInputs = projectionInputs;
+		m_projectionUpdateCount++;
+	}
+
+	if (viewChanged || projectionChanged)
+		m_viewProjection = m_projectionMatrix * m_viewMatrix;
+
+	if (!modelChanged && !viewChanged && !projectionChanged) return false;
+
+	m_modelViewProjection = m_viewProjection * m_modelMatrix;
+	return true;
+}
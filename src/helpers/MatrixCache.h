@@ -0,0 +1,67 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "SceneControls.h"
+
+// Model, view and projection matrices that are only recomputed when their own inputs change.
+// The projection for example only depends on the projection checkboxes, fov, ortho bounds and aspect ratio.
+class MatrixCache
+{
+public:
+	MatrixCache();
+	~MatrixCache();
+
+	// Returns true when the model-view-projection differs from the previous call
+	bool Update(const SceneControls& controls, float aspectRatio);
+
+	inline const glm::mat4& getModelMatrix() const { return m_modelMatrix; }
+	inline const glm::mat4& getViewMatrix() const { return m_viewMatrix; }
+	inline const glm::mat4& getProjectionMatrix() const { return m_projectionMatrix; }
+	inline const glm::mat4& getViewProjection() const { return m_viewProjection; }
+	inline const glm::mat4& getModelViewProjection() const { return m_modelViewProjection; }
+	// How many times each stage really ran, to see the cache working
+	inline unsigned int getModelUpdateCount() const { return m_modelUpdateCount; }
+	inline unsigned int getViewUpdateCount() const { return m_viewUpdateCount; }
+	inline unsigned int getProjectionUpdateCount() const { return m_projectionUpdateCount; }
+private:
+	struct ModelInputs
+	{
+		glm::vec3 translateVector;
+		float rotationXDegrees, rotationYDegrees, rotationZDegrees;
+	};
+
+	struct ViewInputs
+	{
+		bool useViewMatrix;
+		glm::vec3 viewEye, viewCenter, viewUpDown;
+	};
+
+	struct ProjectionInputs
+	{
+		bool useProjectionMatrix;
+		bool showOrthoProjection;
+		float orthoLeft, orthoRight, orthoBottom, orthoTop;
+		float fov;
+		float aspectRatio;
+	};
+
+	static bool SameInputs(const ModelInputs& a, const ModelInputs& b);
+	static bool SameInputs(const ViewInputs& a, const ViewInputs& b);
+	static bool SameInputs(const ProjectionInputs& a, const ProjectionInputs& b);
+
+	bool m_valid = false;
+	ModelInputs m_modelInputs;
+	ViewInputs m_viewInputs;
+	ProjectionInputs m_projectionInputs;
+
+	glm::mat4 m_modelMatrix = glm::mat4(1.0f);
+	glm::mat4 m_viewMatrix = glm::mat4(1.0f);
+	glm::mat4 m_projectionMatrix = glm::mat4(1.0f);
+	glm::mat4 m_viewProjection = glm::mat4(1.0f);
+	glm::mat4 m_modelViewProjection = glm::mat4(1.0f);
+
+	unsigned int m_modelUpdateCount = 0;
+	unsigned int m_viewUpdateCount = 0;
+	unsigned int m_projectionUpdateCount = 0;
+};
@@ -0,0 +1,138 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+static const char meshFileMagic[4] = { 'M', 'V', 'M', 'F' };
+
+static uint64_t alignTo16(uint64_t offset)
+{
+	return (offset + 15) & ~(uint64_t)15;
+}
+
+MeshFile::MeshFile()
+{
+}
+
+MeshFile::~MeshFile()
+{
+}
+
+bool MeshFile::Open(const std::string& filePath)
+{
+	Close();
+
+	if (!m_file.Open(filePath)) {
+		m_error = m_file.getError();
+		return false;
+	}
+
+	if (m_file.getSize() < sizeof(MeshFileHeader)) {
+		m_error = "file too small for a mesh header: " + filePath;
+		Close();
+		return false;
+	}
+
+	const MeshFileHeader* header = (const MeshFileHeader*)m_file.getData();
+	if (std::memcmp(header->magic, meshFileMagic, 4) != 0 || header->version != currentVersion) {
+		m_error = "not a version " + std::to_string(currentVersion) + " mesh file: " + filePath;
+		Close();
+		return false;
+	}
+
+	if (header->vertexFormat != 0 || header->vertexStride != 6 * sizeof(float) || header->indexSize != sizeof(uint32_t)) {
+		m_error = "unsupported vertex or index layout: " + filePath;
+		Close();
+		return false;
+	}
+
+	// Blocks must lie inside the file. Sizes are computed in 64 bits and compared against the space left after
+	// the offset, so a corrupt offset near 2^64 cannot wrap the sum around
+	uint64_t fileSize = m_file.getSize();
+	uint64_t vertexBytes = (uint64_t)header->vertexCount * header->vertexStride;
+	uint64_t indexBytes = (uint64_t)header->indexCount * header->indexSize;
+	if (header->vertexOffset < sizeof(MeshFileHeader) || header->vertexOffset > fileSize || vertexBytes > fileSize - header->vertexOffset ||
+		header->indexOffset < sizeof(MeshFileHeader) || header->indexOffset > fileSize || indexBytes > fileSize - header->indexOffset) {
+		m_error = "mesh blocks outside of the file: " + filePath;
+		Close();
+		return false;
+	}
+
+	// The blocks are read as floats and uint32 straight from the mapping
+	if (header->vertexOffset % 4 != 0 || header->indexOffset % 4 != 0) {
+		m_error = "misaligned mesh blocks: " + filePath;
+		Close();
+		return false;
+	}
+
+	// Like the importer, every index must name a vertex before it reaches a draw or gets packed to 16 bits
+	const uint32_t* indices = (const uint32_t*)(m_file.getData() + header->indexOffset);
+	for (uint32_t i = 0; i < header->indexCount; i++)
+	{
+		if (indices[i] >= header->vertexCount) {
+			m_error = "index " + std::to_string(i) + " references vertex " + std::to_string(indices[i]) + " of " +
+				std::to_string(header->vertexCount) + ": " + filePath;
+			Close();
+			return false;
+		}
+	}
+
+	m_header = header;
+	return true;
+}
+
+void MeshFile::Close()
+{
+	m_file.Close();
+	m_header = nullptr;
+}
+
+bool MeshFile::Write(const std::string& filePath, const MeshData& mesh, std::string& error)
+{
+	MeshFileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, meshFileMagic, 4);
+	header.version = currentVersion;
+	header.vertexFormat = 0;
+	header.vertexStride = 6 * sizeof(float);
+	header.vertexCount = (uint32_t)mesh.getVertexCount();
+	header.indexCount = (uint32_t)mesh.indices.size();
+	header.indexSize = sizeof(uint32_t);
+	header.vertexOffset = alignTo16(sizeof(MeshFileHeader));
+	header.indexOffset = alignTo16(header.vertexOffset + (uint64_t)header.vertexCount * header.vertexStride);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMin[axis] = mesh.getVertexCount() > 0 ? mesh.vertices[axis] : 0.0f;
+		header.boundsMax[axis] = header.boundsMin[axis];
+	}
+	for (size_t i = 0; i < mesh.getVertexCount(); i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			header.boundsMin[axis] = std::min(header.boundsMin[axis], mesh.vertices[i * 6 + axis]);
+			header.boundsMax[axis] = std::max(header.boundsMax[axis], mesh.vertices[i * 6 + axis]);
+		}
+	}
+
+	std::ofstream fileStream(filePath, std::ios::binary);
+	if (!fileStream) {
+		error = "file opening failed: " + filePath;
+		return false;
+	}
+
+	const char padding[16] = { 0 };
+	fileStream.write((const char*)&header, sizeof(header));
+	fileStream.write(padding, header.vertexOffset - sizeof(header));
+	fileStream.write((const char*)mesh.vertices.data(), mesh.vertices.size() * sizeof(float));
+	fileStream.write(padding, header.indexOffset - (header.vertexOffset + mesh.vertices.size() * sizeof(float)));
+	fileStream.write((const char*)mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+
+	if (!fileStream) {
+		error = "writing failed: " + filePath;
+		return false;
+	}
+
+	return true;
+}
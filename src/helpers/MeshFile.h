@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshImporter.h"
+
+// Binary mesh file (.mvmesh), little endian:
+//   MeshFileHeader | interleaved vertex block | index block
+// Both blocks start on a 16 byte boundary so they can be handed to glBufferData straight from the mapping.
+struct MeshFileHeader
+{
+	char magic[4];          // "MVMF"
+	uint32_t version;
+	uint32_t vertexFormat;  // 0: position xyz + color rgb as 32-bit floats
+	uint32_t vertexStride;  // bytes per vertex
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t indexSize;     // bytes per index
+	uint32_t reserved;
+	uint64_t vertexOffset;  // from the start of the file
+	uint64_t indexOffset;
+	float boundsMin[3];
+	float boundsMax[3];
+};
+static_assert(sizeof(MeshFileHeader) == 72, "MeshFileHeader is written to disk as is");
+
+// Zero-copy reader: validates the header and exposes pointers into the memory mapped file
+class MeshFile
+{
+public:
+	MeshFile();
+	~MeshFile();
+
+	bool Open(const std::string& filePath);
+	void Close();
+
+	static bool Write(const std::string& filePath, const MeshData& mesh, std::string& error);
+
+	inline const MeshFileHeader& getHeader() const { return *m_header; }
+	inline const void* getVertexData() const { return m_file.getData() + m_header->vertexOffset; }
+	inline const void* getIndexData() const { return m_file.getData() + m_header->indexOffset; }
+	inline size_t getVertexBytes() const { return (size_t)m_header->vertexCount * m_header->vertexStride; }
+	inline size_t getIndexBytes() const { return (size_t)m_header->indexCount * m_header->indexSize; }
+	inline const std::string& getError() const { return m_error; }
+
+	static const uint32_t currentVersion = 1;
+private:
+	MappedFile m_file;
+	const MeshFileHeader* m_header = nullptr;
+	std::string m_error = "";
+};
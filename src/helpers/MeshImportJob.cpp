@@ -0,0 +1,59 @@
+#include "MeshImportJob.h"
+
+#include <chrono>
+
+MeshImportJob::MeshImportJob()
+{
+}
+
+MeshImportJob::~MeshImportJob()
+{
+	if (m_thread.joinable()) m_thread.join();
+}
+
+bool MeshImportJob::Start(const std::string& filePath)
+{
+	if (isRunning()) return false;
+	if (m_thread.joinable()) m_thread.join();
+
+	if (!m_pool) m_pool.reset(new ThreadPool());
+
+	m_filePath = filePath;
+	m_mesh = MeshData();
+	m_error = "";
+	m_succeeded = false;
+	m_importMs = 0.0;
+	m_progress.bytesParsed = 0;
+	m_progress.totalBytes = 0;
+	m_finished = false;
+
+	m_thread = std::thread([this]()
+	{
+		auto importStart = std::chrono::steady_clock::now();
+		m_succeeded = ImportMeshFile(m_filePath, m_mesh, m_error, m_pool.get(), &m_progress);
+		m_importMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - importStart).count();
+		m_finished = true;
+	});
+
+	return true;
+}
+
+bool MeshImportJob::TakeResult(MeshData& mesh, std::string& error)
+{
+	if (!isFinished()) return false;
+	m_thread.join();
+
+	mesh = std::move(m_mesh);
+	m_mesh = MeshData();
+	error = m_error;
+
+	return m_succeeded;
+}
+
+float MeshImportJob::GetProgress() const
+{
+	size_t totalBytes = m_progress.totalBytes;
+	if (totalBytes == 0) return 0.0f;
+
+	return (float)m_progress.bytesParsed / (float)totalBytes;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "MeshImporter.h"
+#include "ThreadPool.h"
+
+// Runs ImportMeshFile on a background thread and the worker pool so the render loop keeps drawing.
+// The render loop polls isFinished() and picks the mesh up with TakeResult().
+class MeshImportJob
+{
+public:
+	MeshImportJob();
+	~MeshImportJob();
+
+	// false when an import is still running
+	bool Start(const std::string& filePath);
+	// Only valid once isFinished(), returns the import error when it failed
+	bool TakeResult(MeshData& mesh, std::string& error);
+
+	// 0 to 1 of the file bytes parsed so far
+	float GetProgress() const;
+
+	inline bool isRunning() const { return m_thread.joinable() && !m_finished; }
+	inline bool isFinished() const { return m_thread.joinable() && m_finished; }
+	inline const std::string& getFilePath() const { return m_filePath; }
+	inline double getImportMs() const { return m_importMs; }
+private:
+	// Created on the first import, the workers idle in between
+	std::unique_ptr<ThreadPool> m_pool;
+	std::thread m_thread;
+	std::atomic<bool> m_finished{ false };
+	MeshImportProgress m_progress;
+
+	std::string m_filePath = "";
+	MeshData m_mesh;
+	std::string m_error = "";
+	bool m_succeeded = false;
+	double m_importMs = 0.0;
+};
@@ -0,0 +1,885 @@
+#include "MeshImporter.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+// ---- Text parsing on a [p, end) range, the mapped file is not null terminated so no strtod
+
+static inline void skipSpaces(const char*& p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+}
+
+static inline void skipLine(const char*& p, const char* end)
+{
+	while (p < end && *p != '\n') p++;
+	if (p < end) p++;
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static double powerOfTen(int exponent)
+{
+	static const double table[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+		1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	if (exponent >= 0 && exponent <= 22) return table[exponent];
+	if (exponent < 0 && exponent >= -22) return 1.0 / table[-exponent];
+	return std::pow(10.0, exponent);
+}
+
+static bool parseNumber(const char*& p, const char* end, double& value)
+{
+	skipSpaces(p, end);
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	double mantissa = 0.0;
+	int digits = 0;
+	int exponent = 0;
+	while (p < end && isDigit(*p))
+	{
+		mantissa = mantissa * 10.0 + (*p - '0');
+		p++;
+		digits++;
+	}
+	if (p < end && *p == '.')
+	{
+		p++;
+		while (p < end && isDigit(*p))
+		{
+			mantissa = mantissa * 10.0 + (*p - '0');
+			exponent--;
+			p++;
+			digits++;
+		}
+	}
+	if (digits == 0) return false;
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* e = p + 1;
+		bool negativeExponent = false;
+		if (e < end && (*e == '-' || *e == '+'))
+		{
+			negativeExponent = *e == '-';
+			e++;
+		}
+		int exponentValue = 0;
+		int exponentDigits = 0;
+		while (e < end && isDigit(*e))
+		{
+			exponentValue = exponentValue * 10 + (*e - '0');
+			e++;
+			exponentDigits++;
+		}
+		if (exponentDigits > 0)
+		{
+			exponent += negativeExponent ? -exponentValue : exponentValue;
+			p = e;
+		}
+	}
+
+	value = mantissa * powerOfTen(exponent);
+	if (negative) value = -value;
+
+	return true;
+}
+
+static bool parseFloat(const char*& p, const char* end, float& value)
+{
+	double number;
+	if (!parseNumber(p, end, number)) return false;
+	value = (float)number;
+	return true;
+}
+
+static bool parseInteger(const char*& p, const char* end, long long& value)
+{
+	skipSpaces(p, end);
+
+	bool negative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		negative = *p == '-';
+		p++;
+	}
+
+	if (p >= end || !isDigit(*p)) return false;
+	value = 0;
+	while (p < end && isDigit(*p))
+	{
+		value = value * 10 + (*p - '0');
+		p++;
+	}
+	if (negative) value = -value;
+
+	return true;
+}
+
+static std::string nextWord(const char*& p, const char* end)
+{
+	skipSpaces(p, end);
+	const char* start = p;
+	while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+	return std::string(start, p);
+}
+
+// ---- Chunking
+
+// Pieces smaller than this are not worth a task
+static const size_t minChunkBytes = 1 << 20;
+
+struct TextChunk
+{
+	const char* begin;
+	const char* end;
+};
+
+static void forEachChunk(ThreadPool* pool, size_t count, const std::function<void(size_t)>& task)
+{
+	if (pool) pool->ParallelFor(count, task);
+	else for (size_t i = 0; i < count; i++) task(i);
+}
+
+// Cuts [begin, end) into a few pieces per thread, each one ending right after a newline
+static std::vector<TextChunk> splitOnLines(const char* begin, const char* end, ThreadPool* pool)
+{
+	size_t size = (size_t)(end - begin);
+	size_t threadCount = pool ? pool->getThreadCount() + 1 : 1;
+	size_t chunkCount = std::max((size_t)1, std::min(size / minChunkBytes, threadCount * 4));
+
+	std::vector<TextChunk> chunks;
+	const char* chunkBegin = begin;
+	for (size_t i = 1; i <= chunkCount && chunkBegin < end; i++)
+	{
+		const char* chunkEnd = i == chunkCount ? end : std::max(chunkBegin, begin + size / chunkCount * i);
+		while (chunkEnd < end && chunkEnd[-1] != '\n') chunkEnd++;
+		chunks.push_back({ chunkBegin, chunkEnd });
+		chunkBegin = chunkEnd;
+	}
+	return chunks;
+}
+
+static void reportProgress(MeshImportProgress* progress, size_t bytes)
+{
+	if (progress) progress->bytesParsed += bytes;
+}
+
+// ---- Shared post processing
+
+// Checked while still 64 bits wide, so 4294967297 does not wrap around to vertex 1
+static bool checkIndex(long long index, size_t vertexCount, std::string& error)
+{
+	if (index < 0 || index > (long long)UINT32_MAX || (unsigned long long)index >= vertexCount)
+	{
+		error = "face references vertex " + std::to_string(index) + " of " + std::to_string(vertexCount);
+		return false;
+	}
+	return true;
+}
+
+static bool addFan(const std::vector<long long>& polygon, size_t vertexCount, std::vector<unsigned int>& indices, std::string& error)
+{
+	for (long long index : polygon)
+		if (!checkIndex(index, vertexCount, error)) return false;
+
+	for (size_t i = 2; i < polygon.size(); i++)
+	{
+		indices.push_back((unsigned int)polygon[0]);
+		indices.push_back((unsigned int)polygon[i - 1]);
+		indices.push_back((unsigned int)polygon[i]);
+	}
+	return true;
+}
+
+// Vertices without a color get one from their position inside the bounding box
+static void fillMissingColors(MeshData& mesh, const std::vector<unsigned char>& hasColor)
+{
+	size_t vertexCount = mesh.getVertexCount();
+	if (vertexCount == 0) return;
+
+	float boundsMin[3] = { mesh.vertices[0], mesh.vertices[1], mesh.vertices[2] };
+	float boundsMax[3] = { mesh.vertices[0], mesh.vertices[1], mesh.vertices[2] };
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			boundsMin[axis] = std::min(boundsMin[axis], mesh.vertices[i * 6 + axis]);
+			boundsMax[axis] = std::max(boundsMax[axis], mesh.vertices[i * 6 + axis]);
+		}
+	}
+
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		if (hasColor[i]) continue;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			float extent = boundsMax[axis] - boundsMin[axis];
+			mesh.vertices[i * 6 + 3 + axis] = extent > 0.0f ? (mesh.vertices[i * 6 + axis] - boundsMin[axis]) / extent : 0.5f;
+		}
+	}
+}
+
+// Exact bit pattern of one interleaved vertex
+struct VertexKey
+{
+	uint32_t bits[6];
+
+	bool operator==(const VertexKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+};
+
+struct VertexKeyHash
+{
+	size_t operator()(const VertexKey& key) const
+	{
+		uint64_t hash = 14695981039346656037ull;
+		for (uint32_t word : key.bits)
+			hash = (hash ^ word) * 1099511628211ull;
+		return (size_t)(hash ^ (hash >> 32));
+	}
+};
+
+// Folds vertices with identical position and color into one and remaps the indices.
+// Split and re-exported files repeat shared corners per face, this brings them back to one vertex each.
+static void mergeDuplicateVertices(MeshData& mesh, ThreadPool* pool)
+{
+	size_t vertexCount = mesh.getVertexCount();
+	std::vector<unsigned int> remap(vertexCount);
+	std::unordered_map<VertexKey, unsigned int, VertexKeyHash> uniqueVertices;
+	uniqueVertices.reserve(vertexCount);
+
+	// Kept vertices are compacted in place, the write position never passes the read position
+	unsigned int uniqueCount = 0;
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		VertexKey key;
+		std::memcpy(key.bits, &mesh.vertices[i * 6], sizeof(key.bits));
+		auto inserted = uniqueVertices.emplace(key, uniqueCount);
+		if (inserted.second)
+		{
+			if (uniqueCount != i) std::memmove(&mesh.vertices[uniqueCount * 6], &mesh.vertices[i * 6], 6 * sizeof(float));
+			uniqueCount++;
+		}
+		remap[i] = inserted.first->second;
+	}
+	if (uniqueCount == vertexCount) return;
+
+	mesh.vertices.resize((size_t)uniqueCount * 6);
+
+	size_t indexCount = mesh.indices.size();
+	size_t rangeCount = std::max((size_t)1, std::min(indexCount / (minChunkBytes / 4), (size_t)64));
+	forEachChunk(pool, rangeCount, [&](size_t range)
+	{
+		size_t first = indexCount * range / rangeCount;
+		size_t last = indexCount * (range + 1) / rangeCount;
+		for (size_t i = first; i < last; i++)
+			mesh.indices[i] = remap[mesh.indices[i]];
+	});
+}
+
+// ---- OBJ: "v x y z [r g b]" and "f a/b/c ..." lines, everything else is ignored
+
+struct ObjChunk
+{
+	std::vector<float> vertices;
+	std::vector<unsigned char> hasColor;
+	// Fan triangulated. Positive references are final, negative ones count back from the last vertex read
+	// and are stored relative to the first vertex of this chunk until the earlier chunks are counted.
+	std::vector<long long> indices;
+	std::vector<size_t> relativeIndices;
+	std::string error;
+};
+
+static void parseObjChunk(const char* p, const char* end, ObjChunk& chunk)
+{
+	std::vector<long long> polygon;
+	std::vector<unsigned char> polygonRelative;
+
+	while (p < end)
+	{
+		skipSpaces(p, end);
+		if (p + 1 < end && p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 2;
+			float position[3];
+			if (!parseFloat(p, end, position[0]) || !parseFloat(p, end, position[1]) || !parseFloat(p, end, position[2]))
+			{
+				chunk.error = "malformed vertex line";
+				return;
+			}
+
+			float color[3] = { 0.0f, 0.0f, 0.0f };
+			bool vertexHasColor = parseFloat(p, end, color[0]) && parseFloat(p, end, color[1]) && parseFloat(p, end, color[2]);
+
+			chunk.vertices.insert(chunk.vertices.end(), position, position + 3);
+			chunk.vertices.insert(chunk.vertices.end(), color, color + 3);
+			chunk.hasColor.push_back(vertexHasColor);
+		}
+		else if (p + 1 < end && p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+		{
+			p += 2;
+			polygon.clear();
+			polygonRelative.clear();
+			long long vertexCount = (long long)chunk.hasColor.size();
+			long long index;
+			while (parseInteger(p, end, index))
+			{
+				if (index == 0)
+				{
+					chunk.error = "face references vertex 0";
+					return;
+				}
+				// 1 based
+				polygon.push_back(index > 0 ? index - 1 : vertexCount + index);
+				polygonRelative.push_back(index < 0);
+				// texture/normal references are not used
+				while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+			}
+
+			for (size_t i = 2; i < polygon.size(); i++)
+			{
+				size_t corners[3] = { 0, i - 1, i };
+				for (size_t corner : corners)
+				{
+					if (polygonRelative[corner]) chunk.relativeIndices.push_back(chunk.indices.size());
+					chunk.indices.push_back(polygon[corner]);
+				}
+			}
+		}
+		skipLine(p, end);
+	}
+}
+
+static bool importObj(const char* begin, const char* end, MeshData& mesh, std::string& error,
+	ThreadPool* pool, MeshImportProgress* progress)
+{
+	std::vector<TextChunk> textChunks = splitOnLines(begin, end, pool);
+	std::vector<ObjChunk> chunks(textChunks.size());
+
+	forEachChunk(pool, chunks.size(), [&](size_t i)
+	{
+		parseObjChunk(textChunks[i].begin, textChunks[i].end, chunks[i]);
+		reportProgress(progress, (size_t)(textChunks[i].end - textChunks[i].begin));
+	});
+
+	// Where each chunk lands in the merged arrays
+	std::vector<size_t> vertexBase(chunks.size() + 1, 0);
+	std::vector<size_t> indexBase(chunks.size() + 1, 0);
+	for (size_t i = 0; i < chunks.size(); i++)
+	{
+		if (!chunks[i].error.empty())
+		{
+			error = chunks[i].error;
+			return false;
+		}
+		vertexBase[i + 1] = vertexBase[i] + chunks[i].hasColor.size();
+		indexBase[i + 1] = indexBase[i] + chunks[i].indices.size();
+	}
+
+	std::vector<unsigned char> hasColor(vertexBase.back());
+	mesh.vertices.resize(vertexBase.back() * 6);
+	mesh.indices.resize(indexBase.back());
+
+	forEachChunk(pool, chunks.size(), [&](size_t i)
+	{
+		ObjChunk& chunk = chunks[i];
+		std::copy(chunk.vertices.begin(), chunk.vertices.end(), mesh.vertices.begin() + vertexBase[i] * 6);
+		std::copy(chunk.hasColor.begin(), chunk.hasColor.end(), hasColor.begin() + vertexBase[i]);
+
+		for (size_t position : chunk.relativeIndices)
+			chunk.indices[position] += (long long)vertexBase[i];
+		for (size_t n = 0; n < chunk.indices.size(); n++)
+		{
+			if (!checkIndex(chunk.indices[n], vertexBase.back(), chunk.error)) return;
+			mesh.indices[indexBase[i] + n] = (unsigned int)chunk.indices[n];
+		}
+	});
+
+	for (const ObjChunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			error = chunk.error;
+			return false;
+		}
+	}
+
+	fillMissingColors(mesh, hasColor);
+	return true;
+}
+
+// ---- PLY: header describing elements/properties, then an ascii or binary little endian body
+
+enum class PlyType { Int8, Uint8, Int16, Uint16, Int32, Uint32, Float32, Float64, Invalid };
+
+struct PlyProperty
+{
+	std::string name;
+	PlyType type = PlyType::Invalid;
+	bool isList = false;
+	PlyType countType = PlyType::Invalid;
+};
+
+struct PlyElement
+{
+	std::string name;
+	size_t count = 0;
+	std::vector<PlyProperty> properties;
+
+	// Where x/y/z, the colors and the face indices sit in the properties
+	int positionProperty[3] = { -1, -1, -1 };
+	int colorProperty[3] = { -1, -1, -1 };
+	float colorScale[3] = { 1.0f, 1.0f, 1.0f };
+	bool hasColor = false;
+	int faceProperty = -1;
+	// First vertex this element fills, vertex elements only
+	size_t vertexBase = 0;
+
+	inline bool isVertex() const { return name == "vertex"; }
+	inline bool isFace() const { return name == "face"; }
+};
+
+static PlyType parsePlyType(const std::string& name)
+{
+	if (name == "char" || name == "int8") return PlyType::Int8;
+	if (name == "uchar" || name == "uint8") return PlyType::Uint8;
+	if (name == "short" || name == "int16") return PlyType::Int16;
+	if (name == "ushort" || name == "uint16") return PlyType::Uint16;
+	if (name == "int" || name == "int32") return PlyType::Int32;
+	if (name == "uint" || name == "uint32") return PlyType::Uint32;
+	if (name == "float" || name == "float32") return PlyType::Float32;
+	if (name == "double" || name == "float64") return PlyType::Float64;
+	return PlyType::Invalid;
+}
+
+static size_t plyTypeSize(PlyType type)
+{
+	switch (type)
+	{
+	case PlyType::Int8: case PlyType::Uint8: return 1;
+	case PlyType::Int16: case PlyType::Uint16: return 2;
+	case PlyType::Int32: case PlyType::Uint32: case PlyType::Float32: return 4;
+	case PlyType::Float64: return 8;
+	default: return 0;
+	}
+}
+
+// Reads one value in either body encoding and advances p
+static bool readPlyValue(const char*& p, const char* end, PlyType type, bool binary, double& value)
+{
+	if (!binary) return parseNumber(p, end, value);
+
+	size_t size = plyTypeSize(type);
+	if ((size_t)(end - p) < size) return false;
+
+	switch (type)
+	{
+	case PlyType::Int8: { int8_t v; std::memcpy(&v, p, 1); value = v; break; }
+	case PlyType::Uint8: { uint8_t v; std::memcpy(&v, p, 1); value = v; break; }
+	case PlyType::Int16: { int16_t v; std::memcpy(&v, p, 2); value = v; break; }
+	case PlyType::Uint16: { uint16_t v; std::memcpy(&v, p, 2); value = v; break; }
+	case PlyType::Int32: { int32_t v; std::memcpy(&v, p, 4); value = v; break; }
+	case PlyType::Uint32: { uint32_t v; std::memcpy(&v, p, 4); value = v; break; }
+	case PlyType::Float32: { float v; std::memcpy(&v, p, 4); value = v; break; }
+	case PlyType::Float64: { double v; std::memcpy(&v, p, 8); value = v; break; }
+	default: return false;
+	}
+	p += size;
+
+	return true;
+}
+
+// Reads the properties of one element item, the face index list goes to polygon and other lists are skipped
+static bool readPlyItem(const char*& p, const char* end, const PlyElement& element, bool binary,
+	std::vector<double>& values, std::vector<long long>& polygon)
+{
+	for (size_t i = 0; i < element.properties.size(); i++)
+	{
+		const PlyProperty& property = element.properties[i];
+		if (!property.isList)
+		{
+			if (!readPlyValue(p, end, property.type, binary, values[i])) return false;
+			continue;
+		}
+
+		double listSize;
+		if (!readPlyValue(p, end, property.countType, binary, listSize) || !(listSize >= 0.0 && listSize <= (double)UINT32_MAX)) return false;
+
+		bool keep = (int)i == element.faceProperty;
+		if (keep) polygon.clear();
+		for (size_t n = 0; n < (size_t)listSize; n++)
+		{
+			double index;
+			if (!readPlyValue(p, end, property.type, binary, index)) return false;
+			// Out of range or NaN values become -1 instead of undefined conversions, addFan rejects them
+			if (keep) polygon.push_back(index >= 0.0 && index <= (double)UINT32_MAX ? (long long)index : -1);
+		}
+	}
+	return true;
+}
+
+static void storePlyVertex(const PlyElement& element, const std::vector<double>& values, float* vertex)
+{
+	for (int axis = 0; axis < 3; axis++)
+		vertex[axis] = (float)values[element.positionProperty[axis]];
+	for (int axis = 0; axis < 3; axis++)
+		vertex[3 + axis] = element.hasColor ? (float)values[element.colorProperty[axis]] * element.colorScale[axis] : 0.0f;
+}
+
+static bool parsePlyHeader(const char*& p, const char* end, std::vector<PlyElement>& elements, bool& binary, std::string& error)
+{
+	if (nextWord(p, end) != "ply")
+	{
+		error = "missing ply magic";
+		return false;
+	}
+	skipLine(p, end);
+
+	binary = false;
+	bool headerEnded = false;
+
+	while (p < end && !headerEnded)
+	{
+		std::string keyword = nextWord(p, end);
+		if (keyword == "format")
+		{
+			std::string format = nextWord(p, end);
+			if (format == "binary_little_endian") binary = true;
+			else if (format != "ascii")
+			{
+				error = "unsupported ply format " + format;
+				return false;
+			}
+		}
+		else if (keyword == "element")
+		{
+			PlyElement element;
+			element.name = nextWord(p, end);
+			long long count;
+			if (!parseInteger(p, end, count) || count < 0)
+			{
+				error = "malformed ply element";
+				return false;
+			}
+			element.count = (size_t)count;
+			elements.push_back(element);
+		}
+		else if (keyword == "property")
+		{
+			if (elements.empty())
+			{
+				error = "ply property outside an element";
+				return false;
+			}
+			PlyProperty property;
+			std::string type = nextWord(p, end);
+			if (type == "list")
+			{
+				property.isList = true;
+				property.countType = parsePlyType(nextWord(p, end));
+				type = nextWord(p, end);
+			}
+			property.type = parsePlyType(type);
+			property.name = nextWord(p, end);
+			if (property.type == PlyType::Invalid || (property.isList && property.countType == PlyType::Invalid))
+			{
+				error = "unsupported ply property type";
+				return false;
+			}
+			elements.back().properties.push_back(property);
+		}
+		else if (keyword == "end_header")
+		{
+			headerEnded = true;
+		}
+		skipLine(p, end);
+	}
+
+	if (!headerEnded)
+	{
+		error = "ply header has no end";
+		return false;
+	}
+
+	size_t vertexCount = 0;
+	for (PlyElement& element : elements)
+	{
+		for (size_t i = 0; i < element.properties.size(); i++)
+		{
+			const std::string& name = element.properties[i].name;
+			if (name == "x") element.positionProperty[0] = (int)i;
+			else if (name == "y") element.positionProperty[1] = (int)i;
+			else if (name == "z") element.positionProperty[2] = (int)i;
+			else if (name == "red") element.colorProperty[0] = (int)i;
+			else if (name == "green") element.colorProperty[1] = (int)i;
+			else if (name == "blue") element.colorProperty[2] = (int)i;
+			else if ((name == "vertex_indices" || name == "vertex_index") && element.properties[i].isList) element.faceProperty = (int)i;
+		}
+		if (!element.isFace()) element.faceProperty = -1;
+
+		if (!element.isVertex()) continue;
+		if (element.positionProperty[0] < 0 || element.positionProperty[1] < 0 || element.positionProperty[2] < 0)
+		{
+			error = "ply vertices without x/y/z";
+			return false;
+		}
+
+		element.hasColor = element.colorProperty[0] >= 0 && element.colorProperty[1] >= 0 && element.colorProperty[2] >= 0;
+		for (int axis = 0; axis < 3 && element.hasColor; axis++)
+		{
+			// Integer colors are 0-255, float colors already 0-1
+			PlyType colorType = element.properties[element.colorProperty[axis]].type;
+			element.colorScale[axis] = (colorType == PlyType::Float32 || colorType == PlyType::Float64) ? 1.0f : 1.0f / 255.0f;
+		}
+
+		element.vertexBase = vertexCount;
+		vertexCount += element.count;
+	}
+
+	return true;
+}
+
+// Ascii bodies hold one item per line: a first pass counts the lines of every chunk so that the second one
+// knows which element and item each of its lines is, vertices are then written straight to their final place.
+static bool importPlyAscii(const char* begin, const char* end, const std::vector<PlyElement>& elements,
+	MeshData& mesh, std::vector<unsigned char>& hasColor, std::string& error, ThreadPool* pool, MeshImportProgress* progress)
+{
+	std::vector<TextChunk> textChunks = splitOnLines(begin, end, pool);
+
+	std::vector<size_t> firstLine(textChunks.size() + 1, 0);
+	forEachChunk(pool, textChunks.size(), [&](size_t i)
+	{
+		size_t lineCount = (size_t)std::count(textChunks[i].begin, textChunks[i].end, '\n');
+		if (textChunks[i].end > textChunks[i].begin && textChunks[i].end[-1] != '\n') lineCount++;
+		firstLine[i + 1] = lineCount;
+	});
+	for (size_t i = 0; i < textChunks.size(); i++)
+		firstLine[i + 1] += firstLine[i];
+
+	std::vector<size_t> elementFirstLine(elements.size() + 1, 0);
+	for (size_t i = 0; i < elements.size(); i++)
+		elementFirstLine[i + 1] = elementFirstLine[i] + elements[i].count;
+	if (firstLine.back() < elementFirstLine.back())
+	{
+		error = "truncated ply body";
+		return false;
+	}
+
+	struct PlyChunk
+	{
+		std::vector<unsigned int> indices;
+		bool failed = false;
+		std::string error;
+	};
+	std::vector<PlyChunk> chunks(textChunks.size());
+
+	forEachChunk(pool, textChunks.size(), [&](size_t i)
+	{
+		const char* p = textChunks[i].begin;
+		const char* chunkEnd = textChunks[i].end;
+		std::vector<double> values;
+		std::vector<long long> polygon;
+
+		size_t elementIndex = 0;
+		for (size_t line = firstLine[i]; p < chunkEnd && line < elementFirstLine.back(); line++)
+		{
+			while (line >= elementFirstLine[elementIndex + 1]) elementIndex++;
+			const PlyElement& element = elements[elementIndex];
+
+			if (element.isVertex() || element.faceProperty >= 0)
+			{
+				values.resize(element.properties.size());
+				const char* lineEnd = std::find(p, chunkEnd, '\n');
+				if (!readPlyItem(p, lineEnd, element, false, values, polygon))
+				{
+					chunks[i].failed = true;
+					break;
+				}
+
+				if (element.isVertex())
+				{
+					size_t vertex = element.vertexBase + (line - elementFirstLine[elementIndex]);
+					storePlyVertex(element, values, &mesh.vertices[vertex * 6]);
+					hasColor[vertex] = element.hasColor;
+				}
+				else if (!addFan(polygon, mesh.getVertexCount(), chunks[i].indices, chunks[i].error))
+				{
+					break;
+				}
+			}
+			skipLine(p, chunkEnd);
+		}
+		reportProgress(progress, (size_t)(chunkEnd - textChunks[i].begin));
+	});
+
+	for (const PlyChunk& chunk : chunks)
+	{
+		if (chunk.failed)
+		{
+			error = "malformed ply body";
+			return false;
+		}
+		if (!chunk.error.empty())
+		{
+			error = chunk.error;
+			return false;
+		}
+		mesh.indices.insert(mesh.indices.end(), chunk.indices.begin(), chunk.indices.end());
+	}
+	return true;
+}
+
+// Binary bodies have no line breaks to split on: fixed size elements (the vertices) are cut into item ranges
+// and decoded in parallel, elements with lists (the faces) have to be walked in order.
+static bool importPlyBinary(const char* p, const char* end, const std::vector<PlyElement>& elements,
+	MeshData& mesh, std::vector<unsigned char>& hasColor, std::string& error, ThreadPool* pool, MeshImportProgress* progress)
+{
+	for (const PlyElement& element : elements)
+	{
+		const char* elementBegin = p;
+
+		bool fixedSize = true;
+		size_t itemSize = 0;
+		for (const PlyProperty& property : element.properties)
+		{
+			fixedSize = fixedSize && !property.isList;
+			itemSize += plyTypeSize(property.type);
+		}
+
+		if (fixedSize)
+		{
+			if ((size_t)(end - p) / std::max(itemSize, (size_t)1) < element.count)
+			{
+				error = "truncated ply body";
+				return false;
+			}
+
+			if (element.isVertex())
+			{
+				size_t itemsPerRange = std::max(minChunkBytes / std::max(itemSize, (size_t)1), (size_t)1);
+				size_t rangeCount = (element.count + itemsPerRange - 1) / itemsPerRange;
+				forEachChunk(pool, rangeCount, [&](size_t range)
+				{
+					std::vector<double> values(element.properties.size());
+					std::vector<long long> polygon;
+					size_t first = range * itemsPerRange;
+					size_t last = std::min(first + itemsPerRange, element.count);
+					const char* item = elementBegin + first * itemSize;
+					for (size_t n = first; n < last; n++)
+					{
+						readPlyItem(item, end, element, true, values, polygon);
+						storePlyVertex(element, values, &mesh.vertices[(element.vertexBase + n) * 6]);
+						hasColor[element.vertexBase + n] = element.hasColor;
+					}
+					reportProgress(progress, (last - first) * itemSize);
+				});
+			}
+			else
+			{
+				reportProgress(progress, element.count * itemSize);
+			}
+			p += element.count * itemSize;
+			continue;
+		}
+
+		std::vector<double> values(element.properties.size());
+		std::vector<long long> polygon;
+		for (size_t item = 0; item < element.count; item++)
+		{
+			if (!readPlyItem(p, end, element, true, values, polygon))
+			{
+				error = "truncated ply body";
+				return false;
+			}
+			if (element.faceProperty >= 0 && !addFan(polygon, mesh.getVertexCount(), mesh.indices, error)) return false;
+		}
+		reportProgress(progress, (size_t)(p - elementBegin));
+	}
+	return true;
+}
+
+static bool importPly(const char* p, const char* end, MeshData& mesh, std::string& error,
+	ThreadPool* pool, MeshImportProgress* progress)
+{
+	const char* begin = p;
+	std::vector<PlyElement> elements;
+	bool binary;
+	if (!parsePlyHeader(p, end, elements, binary, error)) return false;
+	reportProgress(progress, (size_t)(p - begin));
+
+	size_t vertexCount = 0;
+	for (const PlyElement& element : elements)
+		if (element.isVertex()) vertexCount += element.count;
+
+	std::vector<unsigned char> hasColor(vertexCount);
+	mesh.vertices.resize(vertexCount * 6);
+
+	bool imported = binary ? importPlyBinary(p, end, elements, mesh, hasColor, error, pool, progress)
+		: importPlyAscii(p, end, elements, mesh, hasColor, error, pool, progress);
+	if (!imported) return false;
+
+	fillMissingColors(mesh, hasColor);
+	return true;
+}
+
+bool ImportMeshFile(const std::string& filePath, MeshData& mesh, std::string& error,
+	ThreadPool* pool, MeshImportProgress* progress)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	std::string extension = filePath.substr(filePath.find_last_of('.') + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	if (extension != "obj" && extension != "ply")
+	{
+		error = "unsupported mesh file extension: " + filePath;
+		return false;
+	}
+
+	MappedFile file;
+	if (!file.Open(filePath))
+	{
+		error = file.getError();
+		return false;
+	}
+
+	if (progress)
+	{
+		progress->bytesParsed = 0;
+		progress->totalBytes = file.getSize();
+	}
+
+	const char* begin = (const char*)file.getData();
+	const char* end = begin + file.getSize();
+	bool imported = extension == "obj" ? importObj(begin, end, mesh, error, pool, progress)
+		: importPly(begin, end, mesh, error, pool, progress);
+
+	if (imported && mesh.indices.empty())
+	{
+		error = "mesh has no faces: " + filePath;
+		return false;
+	}
+
+	if (imported) mergeDuplicateVertices(mesh, pool);
+	if (progress) progress->bytesParsed = progress->totalBytes.load();
+
+	return imported;
+}
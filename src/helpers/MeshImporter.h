@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Triangle mesh in the layout the scene VAOs expect
+struct MeshData
+{
+	// interleaved position xyz + color rgb, 6 floats per vertex like the built-in cube
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+
+	inline size_t getVertexCount() const { return vertices.size() / 6; }
+	inline size_t getTriangleCount() const { return indices.size() / 3; }
+};
+
+// Filled in while an import runs, safe to read from another thread
+struct MeshImportProgress
+{
+	std::atomic<size_t> bytesParsed{ 0 };
+	std::atomic<size_t> totalBytes{ 0 };
+};
+
+// Reads a Wavefront OBJ or a PLY (ascii or binary little endian) file, picked by extension.
+// The file is split into chunks on line boundaries that are parsed in parallel on "pool" (sequentially without one),
+// then merged in file order with identical vertices folded together.
+// Polygons are triangulated as fans, vertices without colors get a position based gradient.
+bool ImportMeshFile(const std::string& filePath, MeshData& mesh, std::string& error,
+	ThreadPool* pool = nullptr, MeshImportProgress* progress = nullptr);
@@ -0,0 +1,227 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <glew.h>
+
+Profiler::Profiler()
+	: m_origin(std::chrono::steady_clock::now())
+{
+	// Core since 3.3, the extension check covers older contexts
+	m_gpuTimers = GLEW_ARB_timer_query != 0;
+	if (m_gpuTimers)
+	{
+		for (int slot = 0; slot < queryRingSize; slot++)
+			glGenQueries(maxGpuZones, m_queries[slot]);
+	}
+	for (int slot = 0; slot < queryRingSize; slot++)
+		m_slotPending[slot] = false;
+}
+
+Profiler::~Profiler()
+{
+	if (m_gpuTimers)
+	{
+		for (int slot = 0; slot < queryRingSize; slot++)
+			glDeleteQueries(maxGpuZones, m_queries[slot]);
+	}
+}
+
+double Profiler::NowMs() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+void Profiler::BeginFrame()
+{
+	if (m_inFrame) EndFrame();
+	CollectGpuResults();
+
+	int slot = (int)(m_frameIndex % queryRingSize);
+	if (m_slotPending[slot])
+	{
+		// Still not done after a whole ring of frames, its queries are reused rather than waited on
+		m_droppedGpuFrames++;
+		m_slotPending[slot] = false;
+	}
+	m_pending[slot].frameIndex = m_frameIndex;
+	m_pending[slot].zoneCount = 0;
+
+	ProfileFrame frame;
+	frame.frameIndex = m_frameIndex;
+	frame.startMs = NowMs();
+	m_frames.push_back(frame);
+	if (m_frames.size() > historySize) m_frames.pop_front();
+
+	m_openZones.clear();
+	m_inFrame = true;
+}
+
+void Profiler::EndFrame()
+{
+	if (!m_inFrame) return;
+	while (!m_openZones.empty()) EndZone();
+	if (m_gpuZoneOpen) EndGpuZone();
+
+	ProfileFrame& frame = m_frames.back();
+	frame.cpuMs = NowMs() - frame.startMs;
+
+	int slot = (int)(m_frameIndex % queryRingSize);
+	if (m_pending[slot].zoneCount > 0) m_slotPending[slot] = true;
+	else frame.gpuReady = m_gpuTimers;
+
+	m_inFrame = false;
+	m_frameIndex++;
+}
+
+void Profiler::DiscardFrame()
+{
+	if (!m_inFrame) return;
+	if (m_gpuZoneOpen) EndGpuZone();
+
+	// Queries already issued still finish, their results find no frame and are dropped
+	int slot = (int)(m_frameIndex % queryRingSize);
+	if (m_pending[slot].zoneCount > 0) m_slotPending[slot] = true;
+
+	m_frames.pop_back();
+	m_openZones.clear();
+	m_inFrame = false;
+	m_frameIndex++;
+}
+
+void Profiler::BeginZone(const char* name)
+{
+	if (!m_inFrame) return;
+
+	ProfileFrame& frame = m_frames.back();
+	ProfileZoneTiming zone;
+	zone.name = name;
+	zone.startMs = NowMs();
+	zone.depth = (int)m_openZones.size();
+	m_openZones.push_back(frame.cpuZones.size());
+	frame.cpuZones.push_back(zone);
+}
+
+void Profiler::EndZone()
+{
+	if (!m_inFrame || m_openZones.empty()) return;
+
+	ProfileZoneTiming& zone = m_frames.back().cpuZones[m_openZones.back()];
+	zone.durationMs = NowMs() - zone.startMs;
+	m_openZones.pop_back();
+}
+
+void Profiler::BeginGpuZone(const char* name)
+{
+	if (!m_gpuTimers || !m_inFrame || m_gpuZoneOpen) return;
+
+	PendingGpuZones& pending = m_pending[m_frameIndex % queryRingSize];
+	if (pending.zoneCount >= maxGpuZones) return;
+
+	pending.names[pending.zoneCount] = name;
+	pending.submitMs[pending.zoneCount] = NowMs();
+	glBeginQuery(GL_TIME_ELAPSED, m_queries[m_frameIndex % queryRingSize][pending.zoneCount]);
+	m_gpuZoneOpen = true;
+}
+
+void Profiler::EndGpuZone()
+{
+	if (!m_gpuZoneOpen) return;
+
+	glEndQuery(GL_TIME_ELAPSED);
+	m_pending[m_frameIndex % queryRingSize].zoneCount++;
+	m_gpuZoneOpen = false;
+}
+
+void Profiler::CollectGpuResults()
+{
+	if (!m_gpuTimers) return;
+
+	unsigned int firstFrame = m_frameIndex >= (unsigned int)queryRingSize ? m_frameIndex - queryRingSize : 0;
+	for (unsigned int frameIndex = firstFrame; frameIndex < m_frameIndex; frameIndex++)
+	{
+		int slot = (int)(frameIndex % queryRingSize);
+		const PendingGpuZones& pending = m_pending[slot];
+		if (!m_slotPending[slot] || pending.frameIndex != frameIndex) continue;
+
+		// Queries finish in order, the last one of the frame being available means all of them are
+		GLint available = 0;
+		glGetQueryObjectiv(m_queries[slot][pending.zoneCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+		m_slotPending[slot] = false;
+
+		ProfileFrame* frame = FindFrame(frameIndex);
+		if (!frame) continue;
+
+		// Only durations are measured, each zone is placed at its submit time or after the previous one
+		double gpuEndMs = 0.0;
+		for (int zone = 0; zone < pending.zoneCount; zone++)
+		{
+			GLuint64 elapsedNs = 0;
+			glGetQueryObjectui64v(m_queries[slot][zone], GL_QUERY_RESULT, &elapsedNs);
+
+			ProfileZoneTiming timing;
+			timing.name = pending.names[zone];
+			timing.startMs = std::max(pending.submitMs[zone], gpuEndMs);
+			timing.durationMs = (double)elapsedNs / 1000000.0;
+			gpuEndMs = timing.startMs + timing.durationMs;
+
+			frame->gpuZones.push_back(timing);
+			frame->gpuMs += timing.durationMs;
+		}
+		frame->gpuReady = true;
+	}
+}
+
+ProfileFrame* Profiler::FindFrame(unsigned int frameIndex)
+{
+	// Frame indices only grow, discarded frames leave gaps
+	for (auto it = m_frames.rbegin(); it != m_frames.rend(); ++it)
+	{
+		if (it->frameIndex == frameIndex) return &*it;
+		if (it->frameIndex < frameIndex) break;
+	}
+	return nullptr;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filePath, std::string& error) const
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		error = "Could not open " + filePath;
+		return false;
+	}
+
+	// Complete ("X") events in microseconds, CPU zones on one track and GPU zones on another
+	const int cpuTrack = 1, gpuTrack = 2;
+	file.precision(3);
+	file << std::fixed;
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << cpuTrack << ",\"args\":{\"name\":\"Render thread\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << gpuTrack << ",\"args\":{\"name\":\"GPU\"}}";
+
+	auto writeEvent = [&file](const char* name, const char* category, double startMs, double durationMs, int track)
+	{
+		file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"ts\":" << startMs * 1000.0
+			<< ",\"dur\":" << durationMs * 1000.0 << ",\"pid\":1,\"tid\":" << track << "}";
+	};
+
+	for (const ProfileFrame& frame : m_frames)
+	{
+		std::string frameName = "Frame " + std::to_string(frame.frameIndex);
+		writeEvent(frameName.c_str(), "frame", frame.startMs, frame.cpuMs, cpuTrack);
+		for (const ProfileZoneTiming& zone : frame.cpuZones)
+			writeEvent(zone.name, "cpu", zone.startMs, zone.durationMs, cpuTrack);
+		for (const ProfileZoneTiming& zone : frame.gpuZones)
+			writeEvent(zone.name, "gpu", zone.startMs, zone.durationMs, gpuTrack);
+	}
+
+	file << "\n]}\n";
+
+	if (!file) {
+		error = "Could not write " + filePath;
+		return false;
+	}
+	return true;
+}
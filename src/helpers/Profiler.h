@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+// One timed zone, times in milliseconds since the profiler was created
+struct ProfileZoneTiming
+{
+	const char* name = "";
+	double startMs = 0.0;
+	double durationMs = 0.0;
+	// Nesting level of CPU zones, 0 for the outermost
+	int depth = 0;
+};
+
+struct ProfileFrame
+{
+	unsigned int frameIndex = 0;
+	double startMs = 0.0;
+	double cpuMs = 0.0;
+	// Sum of the GPU zones, only valid once gpuReady is set (a few frames later)
+	double gpuMs = 0.0;
+	bool gpuReady = false;
+	std::vector<ProfileZoneTiming> cpuZones;
+	std::vector<ProfileZoneTiming> gpuZones;
+};
+
+// Per-frame CPU zones and GL_TIME_ELAPSED GPU zones, kept for the last historySize frames.
+// GPU queries go through a ring of query sets, one per frame in flight: results are picked up
+// once available instead of waiting for them, so the GPU times of a frame show up a few frames later.
+// Needs a current OpenGL context, everything runs on the render thread.
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+
+	void BeginFrame();
+	void EndFrame();
+	// Drops the frame started last, e.g. when the render loop decides not to draw after all
+	void DiscardFrame();
+
+	// CPU zones may nest, GPU zones may not (one GL_TIME_ELAPSED query is active at a time)
+	void BeginZone(const char* name);
+	void EndZone();
+	void BeginGpuZone(const char* name);
+	void EndGpuZone();
+
+	// Chrome trace event format, open with chrome://tracing or ui.perfetto.dev
+	bool WriteChromeTrace(const std::string& filePath, std::string& error) const;
+
+	inline const std::deque<ProfileFrame>& getFrames() const { return m_frames; }
+	inline bool hasGpuTimers() const { return m_gpuTimers; }
+	// Frames whose GPU results were still pending when their queries had to be reused
+	inline unsigned int getDroppedGpuFrameCount() const { return m_droppedGpuFrames; }
+
+	static const size_t historySize = 300;
+	static const int queryRingSize = 4;
+	static const int maxGpuZones = 8;
+private:
+	struct PendingGpuZones
+	{
+		unsigned int frameIndex = 0;
+		int zoneCount = 0;
+		const char* names[maxGpuZones];
+		double submitMs[maxGpuZones];
+	};
+
+	double NowMs() const;
+	// Reads every finished query set, oldest first, without blocking
+	void CollectGpuResults();
+	ProfileFrame* FindFrame(unsigned int frameIndex);
+
+	std::chrono::steady_clock::time_point m_origin;
+	std::deque<ProfileFrame> m_frames;
+	unsigned int m_frameIndex = 0;
+	bool m_inFrame = false;
+	std::vector<size_t> m_openZones;
+
+	bool m_gpuTimers = false;
+	unsigned int m_queries[queryRingSize][maxGpuZones];
+	PendingGpuZones m_pending[queryRingSize];
+	bool m_slotPending[queryRingSize];
+	bool m_gpuZoneOpen = false;
+	unsigned int m_droppedGpuFrames = 0;
+};
+
+// Times the enclosing scope as a CPU zone, the profiler may be null
+class ProfileZone
+{
+public:
+	ProfileZone(Profiler* profiler, const char* name) : m_profiler(profiler) { if (m_profiler) m_profiler->BeginZone(name); }
+	~ProfileZone() { if (m_profiler) m_profiler->EndZone(); }
+private:
+	Profiler* m_profiler;
+};
+
+// Same for the GL commands issued in the enclosing scope
+class GpuProfileZone
+{
+public:
+	GpuProfileZone(Profiler* profiler, const char* name) : m_profiler(profiler) { if (m_profiler) m_profiler->BeginGpuZone(name); }
+	~GpuProfileZone() { if (m_profiler) m_profiler->EndGpuZone(); }
+private:
+	Profiler* m_profiler;
+};
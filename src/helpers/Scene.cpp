@@ -0,0 +1,421 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "MeshFile.h"
+
+float vertices[48] = {
+	//     position    |          color
+	-0.5f, -0.5f, -0.5f,	1.0f, 0.0f, 0.0f, // front - bottom left
+	0.5f, -0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - bottom right
+	0.5f, 0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - top right
+	-0.5, 0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - top left
+	-0.5f, -0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - bottom left
+	0.5f, -0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - bottom right
+	0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - top right
+	-0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - top left
+};
+
+unsigned short indices[36] = {
+	0, 1, 2, 0, 2, 3, // front face
+	4, 0, 3, 4, 7, 3, // left face
+	4, 5, 6, 4, 7, 6, // back face
+	1, 5, 6, 1, 2, 6, // right face
+	2, 3, 6, 3, 7, 6, // top face
+	0, 1, 5, 1, 4, 5, // bottom face
+};
+
+float prismVertices[24] = {
+	//		position      |      colors
+	-0.3f, -0.6f, 0.0f,		1.0f, 0.0f, 0.0f, // front - bottom left
+	0.3f, -0.6f, 0.0f,		0.0f, 1.0f, 0.0f, // front - bottom right
+	0.0f, 0.6f, 0.0f,		0.0f, 0.0f, 1.0f, // front - top
+	0.0f, -0.6f, -0.5f,		0.5f, 0.0f, 0.5f, // back
+};
+
+unsigned short prismIndices[12] = {
+	0, 1, 2, // front face
+	0, 1, 3, // bottom face
+	0, 2, 3, // left face
+	1, 2, 3, // right face
+};
+
+// Element counts, the index arrays are 16-bit
+static const GLsizei cubeIndexCount = sizeof(indices) / sizeof(indices[0]);
+static const GLsizei prismIndexCount = sizeof(prismIndices) / sizeof(prismIndices[0]);
+
+// Box around the positions of an interleaved position + color array
+static BoundingBox vertexBounds(const float* vertexData, size_t vertexCount)
+{
+	BoundingBox bounds;
+	for (size_t i = 0; i < vertexCount; i++)
+		bounds.Add(glm::vec3(vertexData[i * 6], vertexData[i * 6 + 1], vertexData[i * 6 + 2]));
+	return bounds;
+}
+
+// Box that holds "bounds" however it is rotated around the origin and then scaled by up to "scale"
+static BoundingBox rotatedBounds(const BoundingBox& bounds, const glm::vec3& center, float scale)
+{
+	float radius = glm::length(glm::max(glm::abs(bounds.min), glm::abs(bounds.max))) * scale;
+	BoundingBox result;
+	result.Add(center - glm::vec3(radius));
+	result.Add(center + glm::vec3(radius));
+	return result;
+}
+
+Scene::Scene(ThreadPool& jobs, ShaderCompileQueue* compileQueue)
+	: m_shaderProgram("resources/vertex.shader", "resources/fragment.shader"),
+	m_geometry(VertexFormat::Float32, GL_UNSIGNED_SHORT, initialPoolVertices, initialPoolIndices),
+	m_instanceStream(initialStreamedMatrices * sizeof(glm::mat4), sizeof(glm::mat4)), m_sceneUpdate(jobs),
+	m_instancedShaderProgram("resources/vertex_instanced.shader", "resources/fragment.shader", compileQueue)
+{
+	// Cube and prism share the pool, the per-instance matrices come from the stream buffer
+	m_cubeMesh = m_geometry.AddMesh(vertices, sizeof(vertices) / sizeof(vertices[0]) / 6, indices, cubeIndexCount);
+	m_prismMesh = m_geometry.AddMesh(prismVertices, sizeof(prismVertices) / sizeof(prismVertices[0]) / 6, prismIndices, prismIndexCount);
+	m_geometry.SetInstanceBuffer(m_instanceStream.getBuffer());
+
+	m_cubeBounds = vertexBounds(vertices, sizeof(vertices) / sizeof(vertices[0]) / 6);
+	m_prismBounds = vertexBounds(prismVertices, sizeof(prismVertices) / sizeof(prismVertices[0]) / 6);
+
+	m_shaderProgram.BindUniformBlock(CameraUniformBuffer::blockName, CameraUniformBuffer::bindingPoint);
+}
+
+Scene::~Scene()
+{
+	ReleaseMeshBuffers();
+}
+
+void Scene::ReleaseMeshBuffers()
+{
+	if (m_meshVao) glDeleteVertexArrays(1, &m_meshVao);
+	if (m_meshVbo) glDeleteBuffers(1, &m_meshVbo);
+	if (m_meshEbo) glDeleteBuffers(1, &m_meshEbo);
+	m_meshVao = m_meshVbo = m_meshEbo = 0;
+}
+
+bool Scene::LoadMesh(const std::string& filePath, std::string& error)
+{
+	MeshFile meshFile;
+	if (!meshFile.Open(filePath)) {
+		error = meshFile.getError();
+		return false;
+	}
+	const MeshFileHeader& header = meshFile.getHeader();
+
+	// Straight from the mapping for large float meshes, otherwise packed on the way
+	UploadMesh((const float*)meshFile.getVertexData(), header.vertexCount, (const uint32_t*)meshFile.getIndexData(), header.indexCount,
+		glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+		glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]));
+
+	return true;
+}
+
+void Scene::LoadMeshData(const MeshData& mesh)
+{
+	glm::vec3 boundsMin = glm::vec3(0.0f);
+	glm::vec3 boundsMax = glm::vec3(0.0f);
+	for (size_t i = 0; i < mesh.getVertexCount(); i++)
+	{
+		glm::vec3 position = glm::vec3(mesh.vertices[i * 6], mesh.vertices[i * 6 + 1], mesh.vertices[i * 6 + 2]);
+		boundsMin = i == 0 ? position : glm::min(boundsMin, position);
+		boundsMax = i == 0 ? position : glm::max(boundsMax, position);
+	}
+
+	UploadMesh(mesh.vertices.data(), (unsigned int)mesh.getVertexCount(), mesh.indices.data(), (unsigned int)mesh.indices.size(),
+		boundsMin, boundsMax);
+}
+
+void Scene::UploadMesh(const float* vertexData, unsigned int vertexCount, const uint32_t* indexData, unsigned int indexCount,
+	const glm::vec3& boundsMin, const glm::vec3& boundsMax)
+{
+	// Fit the largest side of the bounding box into the unit cube around the origin
+	glm::vec3 extent = boundsMax - boundsMin;
+	float largestSide = std::max(extent.x, std::max(extent.y, extent.z));
+	float scale = largestSide > 0.0f ? 1.0f / largestSide : 1.0f;
+	m_meshNormalizeMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(scale)) *
+		glm::translate(glm::mat4(1.0f), (boundsMin + boundsMax) * -0.5f);
+
+	m_geometry.RemoveMesh(m_poolMesh);
+	m_poolMesh = -1;
+
+	// Float vertices with 32-bit indices need no conversion, anything else goes through a packed copy
+	PackedMesh packed;
+	const void* vertexUpload = vertexData;
+	const void* indexUpload = indexData;
+	size_t vertexBytes = (size_t)vertexCount * GetVertexStride(VertexFormat::Float32);
+	size_t indexBytes = (size_t)indexCount * sizeof(uint32_t);
+	m_meshIndexType = GL_UNSIGNED_INT;
+	m_meshDecodeMatrix = glm::mat4(1.0f);
+	if (m_meshVertexFormat != VertexFormat::Float32 || vertexCount <= maxShortIndexVertexCount)
+	{
+		PackMesh(vertexData, vertexCount, indexData, indexCount, boundsMin, boundsMax, m_meshVertexFormat, packed);
+		vertexUpload = packed.vertexData.data();
+		indexUpload = packed.indexData.data();
+		vertexBytes = packed.vertexData.size();
+		indexBytes = packed.indexData.size();
+		m_meshIndexType = packed.indexType;
+		m_meshDecodeMatrix = packed.decodeMatrix;
+	}
+
+	if (m_meshVertexFormat == m_geometry.getVertexFormat() && m_meshIndexType == m_geometry.getIndexType())
+	{
+		// Same layout as the cube, so it joins the pool with the normalization baked into its positions
+		float* positions = (float*)packed.vertexData.data();
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			glm::vec4 position = m_meshNormalizeMatrix * glm::vec4(positions[i * 6], positions[i * 6 + 1], positions[i * 6 + 2], 1.0f);
+			positions[i * 6] = position.x;
+			positions[i * 6 + 1] = position.y;
+			positions[i * 6 + 2] = position.z;
+		}
+		m_poolMesh = m_geometry.AddMesh(positions, vertexCount, indexUpload, indexCount);
+		// A previous mesh may have needed buffers of its own, this one does not
+		ReleaseMeshBuffers();
+		if (m_poolMesh < 0)
+		{
+			// The pool could not grow to fit it, nothing is left to draw
+			m_meshIndexCount = 0;
+			return;
+		}
+	}
+	else
+	{
+		// Compact or 32-bit indexed meshes keep buffers of their own and an extra draw
+		if (!m_meshVao)
+		{
+			glGenVertexArrays(1, &m_meshVao);
+			glGenBuffers(1, &m_meshVbo);
+			glGenBuffers(1, &m_meshEbo);
+		}
+
+		glBindVertexArray(m_meshVao);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_meshVbo);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, vertexUpload, GL_STATIC_DRAW);
+		SetupVertexAttributes(m_meshVertexFormat);
+
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshEbo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, indexUpload, GL_STATIC_DRAW);
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+
+	m_loadedMeshVertexFormat = m_meshVertexFormat;
+	m_meshVertexBytes = vertexBytes;
+	m_meshIndexBytes = indexBytes;
+	m_meshVertexCount = vertexCount;
+	m_meshIndexCount = indexCount;
+	m_meshBounds = BoundingBox();
+	m_meshBounds.Add(boundsMin);
+	m_meshBounds.Add(boundsMax);
+}
+
+void Scene::UpdateInstances(int instanceCount)
+{
+	if (instanceCount < 1) instanceCount = 1;
+	if (instanceCount > maxInstanceCount) instanceCount = maxInstanceCount;
+	if (instanceCount == m_instanceCount) return;
+
+	// Lay the instances out on a cube shaped grid filling clip space, prisms sit half a cell off the cubes
+	int gridSize = (int)std::ceil(std::cbrt((double)instanceCount));
+	float cellSize = 1.6f / (float)gridSize;
+	float gridStart = -0.8f + cellSize / 2.0f;
+	glm::vec3 prismOffset = glm::vec3(cellSize / 2.0f, cellSize / 2.0f, 0.0f);
+
+	TransformBatch instanceTransforms;
+	instanceTransforms.Resize((size_t)instanceCount * 2);
+	// Instances only spin in place, so bounds holding every rotation stay valid while they animate
+	std::vector<BoundingBox> instanceBounds((size_t)instanceCount * 2);
+	for (int i = 0; i < instanceCount; i++)
+	{
+		glm::vec3 position = glm::vec3(
+			gridStart + cellSize * (float)(i % gridSize),
+			gridStart + cellSize * (float)((i / gridSize) % gridSize),
+			gridStart + cellSize * (float)(i / (gridSize * gridSize))
+		);
+		// Give each instance its own spin so the grid does not look like one big cube
+		glm::vec3 rotation = glm::vec3(0.0f, (float)(i * 37 % 360), 0.0f);
+		glm::vec3 scale = glm::vec3(cellSize * 0.5f);
+
+		instanceTransforms.SetTranslation(i, position);
+		instanceTransforms.SetRotation(i, rotation);
+		instanceTransforms.SetScale(i, scale);
+		instanceTransforms.SetTranslation(instanceCount + i, position + prismOffset);
+		instanceTransforms.SetRotation(instanceCount + i, rotation);
+		instanceTransforms.SetScale(instanceCount + i, scale);
+		instanceBounds[i] = rotatedBounds(m_cubeBounds, position, scale.x);
+		instanceBounds[instanceCount + i] = rotatedBounds(m_prismBounds, position + prismOffset, scale.x);
+	}
+	m_instanceHierarchy.Build(instanceBounds);
+	m_cullValid = false;
+
+	// Publishes the first snapshot before returning, it is uploaded with the first culling pass
+	m_sceneUpdate.SetTransforms(instanceTransforms);
+
+	m_instanceCount = instanceCount;
+}
+
+void Scene::UploadVisibleInstances(bool frustumCulling)
+{
+	// Whatever the update stage finished last, possibly the same as the previous frame
+	const SceneSnapshot* snapshot = m_sceneUpdate.GetSnapshot();
+	const glm::mat4& cullMatrix = m_matrixCache.getModelViewProjection();
+
+	bool recull = !m_cullValid || frustumCulling != m_cullEnabled || cullMatrix != m_cullMatrix;
+	if (!recull && snapshot->updateIndex == m_uploadedUpdateIndex) return;
+
+	size_t instanceCount = (size_t)m_instanceCount;
+	size_t cubeCount = instanceCount, prismCount = instanceCount;
+	if (frustumCulling)
+	{
+		// The grid is in the space the global model matrix applies to, so the planes come from the full MVP
+		if (recull) m_instanceHierarchy.Query(Frustum(cullMatrix), m_visibleInstances);
+		cubeCount = std::count_if(m_visibleInstances.begin(), m_visibleInstances.end(),
+			[instanceCount](unsigned int object) { return object < instanceCount; });
+		prismCount = m_visibleInstances.size() - cubeCount;
+	}
+
+	// Visible cube matrices then visible prism matrices, written straight into the next segment
+	glm::mat4* matrices = (glm::mat4*)m_instanceStream.Begin((cubeCount + prismCount) * sizeof(glm::mat4));
+	if (!frustumCulling)
+	{
+		// Everything drawn, the snapshot already has the layout
+		std::memcpy(matrices, snapshot->instanceMatrices.data(), snapshot->instanceMatrices.size() * sizeof(glm::mat4));
+	}
+	else
+	{
+		size_t cube = 0, prism = cubeCount;
+		for (unsigned int object : m_visibleInstances)
+		{
+			if (object < instanceCount)
+				matrices[cube++] = snapshot->instanceMatrices[object];
+			else
+				matrices[prism++] = snapshot->instanceMatrices[object];
+		}
+	}
+	m_instanceStream.End();
+
+	// Growing replaces the buffer, the pool VAO has to follow
+	if (m_geometry.getInstanceBuffer() != m_instanceStream.getBuffer())
+		m_geometry.SetInstanceBuffer(m_instanceStream.getBuffer());
+
+	m_firstCubeInstance = (unsigned int)(m_instanceStream.getOffset() / sizeof(glm::mat4));
+	m_firstPrismInstance = m_firstCubeInstance + (unsigned int)cubeCount;
+	m_visibleCubeCount = (int)cubeCount;
+	m_visiblePrismCount = (int)prismCount;
+
+	m_uploadedUpdateIndex = snapshot->updateIndex;
+	m_cullMatrix = cullMatrix;
+	m_cullEnabled = frustumCulling;
+	m_cullValid = true;
+}
+
+void Scene::Draw(const SceneControls& controls, float aspectRatio)
+{
+	glClearColor(0.1f, 0.1f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// View and projection go through the camera buffer once per frame, draws only send their model matrix
+	{
+		ProfileZone zone(m_profiler, "Matrix update");
+		m_matrixCache.Update(controls, aspectRatio);
+		m_cameraUniforms.Update(m_matrixCache);
+	}
+	m_cameraUniforms.Bind();
+	const glm::mat4& modelMatrix = m_matrixCache.getModelMatrix();
+	m_drawCommands.clear();
+	m_geometry.setUseMultiDrawIndirect(controls.multiDrawIndirect);
+
+	// Until the instanced shader is built the single cube stands in for the grid, and for good if it failed to build
+	if (controls.useInstancing && m_instancedShaderProgram.isReady() && m_instancedShaderProgram.isLinked())
+	{
+		UpdateInstances(controls.instanceCount);
+		if (m_lockstepUpdates) m_sceneUpdate.Wait();
+		UploadVisibleInstances(controls.frustumCulling);
+		// The next matrices are composed on the workers while this frame is submitted
+		m_sceneUpdate.Kick(controls.animateInstances);
+
+		if (!m_instancedProgramPrepared)
+		{
+			m_instancedShaderProgram.BindUniformBlock(CameraUniformBuffer::blockName, CameraUniformBuffer::bindingPoint);
+			m_instancedProgramPrepared = true;
+		}
+
+		glUseProgram(m_instancedShaderProgram.getProgramId());
+		glUniformMatrix4fv(m_instancedShaderProgram.GetUniformLocation("model"), 1, GL_FALSE, &modelMatrix[0][0]);
+
+		// Cube and prism instances in one submission, each command reads its own part of the instance buffer
+		m_drawnObjectCount = m_visibleCubeCount;
+		m_culledObjectCount = m_instanceCount - m_visibleCubeCount;
+		if (m_visibleCubeCount > 0)
+			m_drawCommands.push_back(m_geometry.GetDrawCommand(m_cubeMesh, m_visibleCubeCount, m_firstCubeInstance));
+
+		if (controls.showPrism)
+		{
+			m_drawnObjectCount += m_visiblePrismCount;
+			m_culledObjectCount += m_instanceCount - m_visiblePrismCount;
+			if (m_visiblePrismCount > 0)
+				m_drawCommands.push_back(m_geometry.GetDrawCommand(m_prismMesh, m_visiblePrismCount, m_firstPrismInstance));
+		}
+
+		m_geometry.Draw(m_drawCommands);
+		// The segment read by these draws is only written again once they are done
+		m_instanceStream.Fence();
+		glBindVertexArray(0);
+		return;
+	}
+
+	glUseProgram(m_shaderProgram.getProgramId());
+	int modelLocation = m_shaderProgram.GetUniformLocation("model");
+	glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &modelMatrix[0][0]);
+
+	// Single objects are tested against the frustum on their own, no hierarchy for two or three boxes
+	const glm::mat4& modelViewProjection = m_matrixCache.getModelViewProjection();
+	Frustum frustum(modelViewProjection);
+	m_drawnObjectCount = 0;
+	m_culledObjectCount = 0;
+
+	if (controls.showLoadedMesh && hasLoadedMesh())
+	{
+		if (!controls.frustumCulling || Frustum(modelViewProjection * m_meshNormalizeMatrix).IsVisible(m_meshBounds))
+		{
+			if (m_poolMesh >= 0) m_drawCommands.push_back(m_geometry.GetDrawCommand(m_poolMesh));
+			else
+			{
+				glm::mat4 meshModelMatrix = modelMatrix * m_meshNormalizeMatrix * m_meshDecodeMatrix;
+				glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &meshModelMatrix[0][0]);
+
+				glBindVertexArray(m_meshVao);
+				glDrawElements(GL_TRIANGLES, m_meshIndexCount, m_meshIndexType, (void*)0);
+				glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &modelMatrix[0][0]);
+			}
+			m_drawnObjectCount++;
+		}
+		else m_culledObjectCount++;
+	}
+	else if (!controls.frustumCulling || frustum.IsVisible(m_cubeBounds))
+	{
+		m_drawCommands.push_back(m_geometry.GetDrawCommand(m_cubeMesh));
+		m_drawnObjectCount++;
+	}
+	else m_culledObjectCount++;
+
+	if (controls.showPrism)
+	{
+		if (!controls.frustumCulling || frustum.IsVisible(m_prismBounds))
+		{
+			m_drawCommands.push_back(m_geometry.GetDrawCommand(m_prismMesh));
+			m_drawnObjectCount++;
+		}
+		else m_culledObjectCount++;
+	}
+
+	m_geometry.Draw(m_drawCommands);
+	glBindVertexArray(0);
+}
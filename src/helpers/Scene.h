@@ -0,0 +1,126 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glew.h>
+#include <glm/glm.hpp>
+
+#include "BoundingVolumeHierarchy.h"
+#include "CameraUniformBuffer.h"
+#include "GeometryPool.h"
+#include "MatrixCache.h"
+#include "MeshImporter.h"
+#include "Profiler.h"
+#include "ShaderProgram.h"
+#include "SceneControls.h"
+#include "SceneUpdate.h"
+#include "StreamBuffer.h"
+#include "TransformBatch.h"
+#include "VertexFormat.h"
+
+// Cube and prism geometry in a shared pool plus the shaders drawing them.
+// Needs a current OpenGL context, shared by the windowed and the headless paths.
+class Scene
+{
+public:
+	// Instance animation runs on "jobs". With a compile queue the instanced shader is built in the background,
+	// the grid is drawn once it is ready
+	Scene(ThreadPool& jobs, ShaderCompileQueue* compileQueue = nullptr);
+	~Scene();
+
+	void Draw(const SceneControls& controls, float aspectRatio);
+	// Uploads a .mvmesh file straight from its memory mapping into a VBO/EBO
+	bool LoadMesh(const std::string& filePath, std::string& error);
+	// Uploads an imported mesh, e.g. the result of a MeshImportJob
+	void LoadMeshData(const MeshData& mesh);
+
+	// Optional, Draw then reports its matrix update as a zone
+	inline void setProfiler(Profiler* profiler) { m_profiler = profiler; }
+	// Draw waits for the instance update started by the previous frame, so every frame advances the animation
+	// by exactly one step. Slower, but recorded input replays to the same matrices
+	inline void setLockstepUpdates(bool lockstep) { m_lockstepUpdates = lockstep; }
+
+	inline const MatrixCache& getMatrixCache() const { return m_matrixCache; }
+	inline const CameraUniformBuffer& getCameraUniforms() const { return m_cameraUniforms; }
+	inline const SceneUpdate& getSceneUpdate() const { return m_sceneUpdate; }
+	// Update the instance matrices of the last Draw came from
+	inline unsigned int getUploadedUpdateIndex() const { return m_uploadedUpdateIndex; }
+	inline bool isInstancedShaderReady() const { return m_instancedShaderProgram.isReady(); }
+	inline const ShaderProgram& getInstancedShaderProgram() const { return m_instancedShaderProgram; }
+	// Layout used by the next LoadMesh/LoadMeshData
+	inline void setMeshVertexFormat(VertexFormat format) { m_meshVertexFormat = format; }
+
+	inline bool hasLoadedMesh() const { return m_meshIndexCount > 0; }
+	inline unsigned int getLoadedMeshVertexCount() const { return m_meshVertexCount; }
+	inline unsigned int getLoadedMeshTriangleCount() const { return m_meshIndexCount / 3; }
+	inline VertexFormat getLoadedMeshVertexFormat() const { return m_loadedMeshVertexFormat; }
+	inline bool hasShortMeshIndices() const { return m_meshIndexType == GL_UNSIGNED_SHORT; }
+	inline size_t getLoadedMeshVertexBytes() const { return m_meshVertexBytes; }
+	inline size_t getLoadedMeshIndexBytes() const { return m_meshIndexBytes; }
+	// Objects of the last Draw that passed or failed the frustum test
+	inline int getDrawnObjectCount() const { return m_drawnObjectCount; }
+	inline int getCulledObjectCount() const { return m_culledObjectCount; }
+	inline const GeometryPool& getGeometryPool() const { return m_geometry; }
+	inline const StreamBuffer& getInstanceStream() const { return m_instanceStream; }
+
+	static const int maxInstanceCount = 100000;
+private:
+	void UpdateInstances(int instanceCount);
+	// Culls the grid when the MVP or the snapshot changed and packs the visible matrices into the next stream segment
+	void UploadVisibleInstances(bool frustumCulling);
+	void UploadMesh(const float* vertexData, unsigned int vertexCount, const uint32_t* indexData, unsigned int indexCount,
+		const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+	// Buffers of a loaded mesh that did not fit the pool
+	void ReleaseMeshBuffers();
+
+	Profiler* m_profiler = nullptr;
+	bool m_lockstepUpdates = false;
+
+	MatrixCache m_matrixCache;
+	CameraUniformBuffer m_cameraUniforms;
+
+	ShaderProgram m_shaderProgram;
+
+	// Cube, prism and (when it fits the layout) the loaded mesh, drawn with one submission per frame
+	GeometryPool m_geometry;
+	int m_cubeMesh = -1, m_prismMesh = -1, m_poolMesh = -1;
+	std::vector<DrawElementsIndirectCommand> m_drawCommands;
+	static const unsigned int initialPoolVertices = 65536, initialPoolIndices = 196608;
+
+	// Loaded mesh, scaled and centered to the size of the cube. Own buffers only outside the pool
+	unsigned int m_meshVao = 0, m_meshVbo = 0, m_meshEbo = 0;
+	unsigned int m_meshVertexCount = 0;
+	unsigned int m_meshIndexCount = 0;
+	glm::mat4 m_meshNormalizeMatrix = glm::mat4(1.0f);
+	// GPU layout of the loaded mesh, compact formats store positions relative to its bounds
+	VertexFormat m_meshVertexFormat = VertexFormat::Float32;
+	VertexFormat m_loadedMeshVertexFormat = VertexFormat::Float32;
+	glm::mat4 m_meshDecodeMatrix = glm::mat4(1.0f);
+	GLenum m_meshIndexType = GL_UNSIGNED_INT;
+	size_t m_meshVertexBytes = 0, m_meshIndexBytes = 0;
+
+	// Object space bounds of each mesh
+	BoundingBox m_cubeBounds, m_prismBounds, m_meshBounds;
+
+	// Instancing: the pool VAO reads the matrices from the stream buffer, base instances select the current segment
+	StreamBuffer m_instanceStream;
+	unsigned int m_firstCubeInstance = 0, m_firstPrismInstance = 0;
+	static const size_t initialStreamedMatrices = 4096;
+	int m_instanceCount = 0;
+	SceneUpdate m_sceneUpdate;
+	unsigned int m_uploadedUpdateIndex = 0;
+
+	// Culling: hierarchy over the grid built with it, redone only when the MVP changes
+	BoundingVolumeHierarchy m_instanceHierarchy;
+	std::vector<unsigned int> m_visibleInstances;
+	glm::mat4 m_cullMatrix = glm::mat4(1.0f);
+	bool m_cullEnabled = false;
+	bool m_cullValid = false;
+	int m_visibleCubeCount = 0, m_visiblePrismCount = 0;
+	int m_drawnObjectCount = 0, m_culledObjectCount = 0;
+
+	ShaderProgram m_instancedShaderProgram;
+	// Camera block bound, done once the program is ready
+	bool m_instancedProgramPrepared = false;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Everything the ImGui panel can change, kept together so the scene can also be driven without a window
+struct SceneControls
+{
+	// ---- Objects
+	bool showPrism = false;
+	// Instanced grid of cubes (and prisms), drawn with one submission
+	bool useInstancing = false;
+	int instanceCount = 1000;
+	bool animateInstances = false;
+	// Mesh loaded from a .mvmesh file, drawn in place of the cube
+	bool showLoadedMesh = false;
+	// Skip objects outside the view volume of the current projection
+	bool frustumCulling = true;
+	// One glMultiDrawElementsIndirect for the whole scene where the context has it
+	bool multiDrawIndirect = true;
+
+	// ---- MVP
+	// Model
+	glm::vec3 translateVector = glm::vec3(0.0f, 0.0f, 0.0f);
+	float rotationXDegrees = 0.0f;
+	float rotationYDegrees = 0.0f;
+	float rotationZDegrees = 0.0f;
+	// View
+	glm::vec3 viewEye = glm::vec3(0.0f, 0.0f, 1.1f);
+	glm::vec3 viewCenter = glm::vec3(0.0f, 0.0f, 0.0f);
+	glm::vec3 viewUpDown = glm::vec3(0.0f, 1.0f, 0.0f);
+	// Ortho
+	float orthoLeft = 0.0f;
+	float orthoRight = 0.0f;
+	float orthoBottom = 0.0f;
+	float orthoTop = 0.0f;
+	// Perspective
+	float fov = 45.0f;
+
+	// Checkbox for choosing projection
+	bool showOrthoProjection = true;
+	bool useViewMatrix = false;
+	bool useProjectionMatrix = false;
+
+	inline void setOrthoFromSize(int width, int height)
+	{
+		orthoLeft = -(float)width / 200.0f; // -aspectRatio * size / 2.0f;
+		orthoRight = (float)width / 200.0f; // aspectRatio * size / 2.0f;
+		orthoBottom = -(float)height / 200.0f; // -size / 2.0f;
+		orthoTop = (float)height / 200.0f; // size / 2.0f;
+	}
+};
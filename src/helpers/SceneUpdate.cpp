@@ -0,0 +1,81 @@
+#include "SceneUpdate.h"
+
+#include <algorithm>
+#include <chrono>
+
+SceneUpdate::SceneUpdate(ThreadPool& pool)
+	: m_pool(pool)
+{
+}
+
+SceneUpdate::~SceneUpdate()
+{
+	Wait();
+}
+
+void SceneUpdate::SetTransforms(const TransformBatch& transforms)
+{
+	Wait();
+	m_transforms = transforms;
+
+	// Whatever was published last is picked up so the other snapshot is free, then filled right away
+	GetSnapshot();
+	int target = m_front < 0 ? 0 : 1 - m_front;
+	m_snapshots[target].instanceMatrices.resize(m_transforms.size());
+	m_running = true;
+	Run(target, false);
+}
+
+const SceneSnapshot* SceneUpdate::GetSnapshot()
+{
+	m_front = m_published.load(std::memory_order_acquire);
+	return m_front < 0 ? nullptr : &m_snapshots[m_front];
+}
+
+void SceneUpdate::Kick(bool animate)
+{
+	// Nothing moves, the published matrices stay valid
+	if (!animate) return;
+	if (m_running.load(std::memory_order_acquire)) return;
+	// The render thread still has to pick up the newest snapshot, the other one may not be touched yet
+	if (m_front != m_published.load(std::memory_order_acquire)) return;
+
+	int target = m_front < 0 ? 0 : 1 - m_front;
+	m_snapshots[target].instanceMatrices.resize(m_transforms.size());
+
+	m_running = true;
+	m_pool.Submit([this, target, animate]() { Run(target, animate); });
+}
+
+void SceneUpdate::Wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_finished.wait(lock, [this]() { return !m_running; });
+}
+
+void SceneUpdate::Run(int target, bool animate)
+{
+	auto updateStart = std::chrono::steady_clock::now();
+
+	SceneSnapshot& snapshot = m_snapshots[target];
+	size_t objectCount = m_transforms.size();
+
+	// Each chunk steps and composes its own objects, idle workers steal the remaining chunks
+	m_pool.ParallelFor(getChunkCount(), [this, &snapshot, objectCount, animate](size_t chunk)
+	{
+		size_t first = chunk * chunkSize;
+		size_t last = std::min(first + chunkSize, objectCount);
+		// Fixed step per update rather than per second, so a given update always shows the same grid
+		if (animate) m_transforms.AddRotation(glm::vec3(0.5f, 1.0f, 0.0f), first, last);
+		m_transforms.ComputeModelMatrices(snapshot.instanceMatrices.data(), first, last);
+	});
+
+	snapshot.updateIndex = ++m_publishedCount;
+	m_lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - updateStart).count();
+	m_published.store(target, std::memory_order_release);
+
+	// Notified under the lock, a waiting destructor must not free the condition variable under our feet
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_running = false;
+	m_finished.notify_all();
+}
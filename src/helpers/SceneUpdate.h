@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "ThreadPool.h"
+#include "TransformBatch.h"
+
+// Instance matrices of one finished update, not written again while the render thread may read it
+struct SceneSnapshot
+{
+	std::vector<glm::mat4> instanceMatrices;
+	unsigned int updateIndex = 0;
+};
+
+// Steps the instance animation and composes the matrices on the thread pool, split into chunks of objects.
+// Results go to two snapshots: the render thread reads the published one without taking a lock
+// while the next update fills the other, and a new update only starts once the render thread picked up the last one.
+class SceneUpdate
+{
+public:
+	explicit SceneUpdate(ThreadPool& pool);
+	~SceneUpdate();
+
+	// Render thread: replaces every transform and publishes their matrices before returning
+	void SetTransforms(const TransformBatch& transforms);
+	// Render thread, once per frame: latest published snapshot, nullptr before the first one
+	const SceneSnapshot* GetSnapshot();
+	// Render thread: starts the next update in the background unless one is running or the last one was not picked up yet
+	void Kick(bool animate);
+	// Blocks until no update is running
+	void Wait();
+
+	inline size_t getObjectCount() const { return m_transforms.size(); }
+	inline size_t getChunkCount() const { return (m_transforms.size() + chunkSize - 1) / chunkSize; }
+	inline double getLastUpdateMs() const { return m_lastUpdateMs; }
+	inline unsigned int getPublishedCount() const { return m_publishedCount; }
+	inline unsigned int getStealCount() const { return m_pool.getStealCount(); }
+
+	// Objects per job, a multiple of the AVX2 width so only the last chunk has a scalar tail
+	static const size_t chunkSize = 2048;
+private:
+	// On a pool worker
+	void Run(int target, bool animate);
+
+	ThreadPool& m_pool;
+
+	// Only touched by the running update, or by the render thread while none runs
+	TransformBatch m_transforms;
+
+	SceneSnapshot m_snapshots[2];
+	std::atomic<int> m_published{ -1 };
+	// Snapshot the render thread reads, only used on the render thread
+	int m_front = -1;
+
+	std::atomic<bool> m_running{ false };
+	std::mutex m_mutex;
+	std::condition_variable m_finished;
+
+	std::atomic<double> m_lastUpdateMs{ 0.0 };
+	std::atomic<unsigned int> m_publishedCount{ 0 };
+};
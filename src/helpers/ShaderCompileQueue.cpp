@@ -0,0 +1,85 @@
+#include "ShaderCompileQueue.h"
+#include "ShaderProgram.h"
+
+#include <algorithm>
+
+#include <glew.h>
+
+ShaderCompileQueue::ShaderCompileQueue(std::function<bool()> makeContextCurrent, std::function<void()> releaseContext)
+	: m_makeContextCurrent(makeContextCurrent), m_releaseContext(releaseContext)
+{
+	m_worker = std::thread(&ShaderCompileQueue::WorkerLoop, this);
+
+	// Know whether the context works before anything gets queued
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this]() { return m_started; });
+}
+
+ShaderCompileQueue::~ShaderCompileQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_changed.notify_all();
+
+	m_worker.join();
+}
+
+void ShaderCompileQueue::Enqueue(ShaderProgram* program)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pending.push_back(program);
+	}
+	m_changed.notify_all();
+}
+
+void ShaderCompileQueue::Remove(ShaderProgram* program)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_pending.erase(std::remove(m_pending.begin(), m_pending.end(), program), m_pending.end());
+	m_changed.wait(lock, [this, program]() { return m_building != program; });
+}
+
+void ShaderCompileQueue::WaitUntilIdle()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_changed.wait(lock, [this]() { return m_pending.empty() && m_building == nullptr; });
+}
+
+void ShaderCompileQueue::WorkerLoop()
+{
+	bool contextCurrent = m_makeContextCurrent();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_started = true;
+		m_valid = contextCurrent;
+	}
+	m_changed.notify_all();
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_building = nullptr;
+			m_changed.notify_all();
+
+			m_changed.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+			if (m_stopping) break;
+
+			m_building = m_pending.front();
+			m_pending.pop_front();
+		}
+
+		// Without a context nothing can be built, the program stays not ready
+		if (!contextCurrent) continue;
+
+		m_building->Build();
+		// Objects changed in one context are only safe to use from another once the commands completed
+		glFinish();
+		m_building->m_ready = true;
+	}
+
+	if (contextCurrent) m_releaseContext();
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class ShaderProgram;
+
+// Builds shader programs on a worker thread owning a second OpenGL context that shares objects with the
+// render context, so programs not needed for the first frame do not delay it.
+// Must outlive the programs queued on it.
+class ShaderCompileQueue
+{
+public:
+	// Both run on the worker thread: bind the shared context there, and release it before the thread ends
+	ShaderCompileQueue(std::function<bool()> makeContextCurrent, std::function<void()> releaseContext);
+	~ShaderCompileQueue();
+
+	ShaderCompileQueue(const ShaderCompileQueue&) = delete;
+	ShaderCompileQueue& operator=(const ShaderCompileQueue&) = delete;
+
+	void Enqueue(ShaderProgram* program);
+	// Drops a program that was not built yet, waits for it when the worker is building it right now
+	void Remove(ShaderProgram* program);
+	// Blocks until every queued program is built
+	void WaitUntilIdle();
+
+	// false when the shared context could not be made current, programs have to be built synchronously then
+	inline bool isValid() const { return m_valid; }
+private:
+	void WorkerLoop();
+
+	std::function<bool()> m_makeContextCurrent;
+	std::function<void()> m_releaseContext;
+
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	std::deque<ShaderProgram*> m_pending;
+	ShaderProgram* m_building = nullptr;
+	bool m_started = false;
+	bool m_valid = false;
+	bool m_stopping = false;
+};
@@ -1,39 +1,255 @@
 #include "ShaderProgram.h"
 #include "FileParser.h"
+#include "ShaderCompileQueue.h"
 
-ShaderProgram::ShaderProgram(const std::string& vertexFilePath, const std::string& fragmentFilePath)
-	: m_vertexFilePath(vertexFilePath), m_fragmentFilePath(fragmentFilePath)
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::string ShaderProgram::s_binaryCacheDirectory = "shader_cache";
+
+// Start of every cached program binary file, the driver blob follows
+struct ProgramBinaryHeader
+{
+	char magic[4];          // "MVPB"
+	uint32_t binaryFormat;  // as returned by glGetProgramBinary
+	uint32_t binaryLength;
+	uint32_t reserved;
+};
+
+static const char programBinaryMagic[4] = { 'M', 'V', 'P', 'B' };
+
+static void hashString(uint64_t& hash, const char* text)
+{
+	// FNV-1a, the terminator is hashed too so "ab" + "c" differs from "a" + "bc"
+	for (const char* c = text ? text : ""; ; c++)
+	{
+		hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+		if (*c == '\0') break;
+	}
+}
+
+static bool binaryCacheSupported()
+{
+	if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) return false;
+
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+static void createDirectory(const std::string& path)
+{
+#ifdef _WIN32
+	_mkdir(path.c_str());
+#else
+	mkdir(path.c_str(), 0755);
+#endif
+}
+
+ShaderProgram::ShaderProgram(const std::string& vertexFilePath, const std::string& fragmentFilePath, ShaderCompileQueue* compileQueue)
+	: m_vertexFilePath(vertexFilePath), m_fragmentFilePath(fragmentFilePath), m_compileQueue(compileQueue)
 {
+	if (m_compileQueue)
+	{
+		m_compileQueue->Enqueue(this);
+		return;
+	}
+
+	Build();
+	m_ready = true;
+}
+
+ShaderProgram::~ShaderProgram()
+{
+	// Not built yet or still building on the worker
+	if (m_compileQueue && !m_ready) m_compileQueue->Remove(this);
+
+	if (m_shaderProgram) glDeleteProgram(m_shaderProgram);
+}
+
+void ShaderProgram::SetBinaryCacheDirectory(const std::string& directory)
+{
+	s_binaryCacheDirectory = directory;
+}
+
+int ShaderProgram::GetUniformLocation(const std::string& name)
+{
+	auto found = m_uniformLocations.find(name);
+	if (found != m_uniformLocations.end()) return found->second;
+
+	int location = glGetUniformLocation(m_shaderProgram, name.c_str());
+	m_uniformLocations[name] = location;
+
+	return location;
+}
+
+void ShaderProgram::BindUniformBlock(const std::string& blockName, unsigned int bindingPoint)
+{
+	unsigned int blockIndex = glGetUniformBlockIndex(m_shaderProgram, blockName.c_str());
+	if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(m_shaderProgram, blockIndex, bindingPoint);
+}
+
+void ShaderProgram::Build()
+{
+	auto buildStart = std::chrono::steady_clock::now();
+
+	std::string vertexSource = ReadResourceFileToStr(m_vertexFilePath);
+	std::string fragmentSource = ReadResourceFileToStr(m_fragmentFilePath);
+
 	// Create program
 	m_shaderProgram = glCreateProgram();
 
-	m_vertexShader = AddShader(m_vertexFilePath, GL_VERTEX_SHADER);
-	m_fragmentShader = AddShader(m_fragmentFilePath, GL_FRAGMENT_SHADER);
+	// Same sources on the same driver give the same file
+	std::string cachePath = "";
+	if (!s_binaryCacheDirectory.empty() && binaryCacheSupported())
+	{
+		uint64_t hash = 14695981039346656037ull;
+		hashString(hash, vertexSource.c_str());
+		hashString(hash, fragmentSource.c_str());
+		hashString(hash, (const char*)glGetString(GL_VENDOR));
+		hashString(hash, (const char*)glGetString(GL_RENDERER));
+		hashString(hash, (const char*)glGetString(GL_VERSION));
+
+		char fileName[32];
+		snprintf(fileName, sizeof(fileName), "%016llx.bin", (unsigned long long)hash);
+		cachePath = s_binaryCacheDirectory + "/" + fileName;
+	}
 
-	glLinkProgram(m_shaderProgram);
-	glUseProgram(m_shaderProgram);
+	if (!cachePath.empty() && LoadBinary(cachePath))
+	{
+		m_loadedFromCache = true;
+		m_linked = true;
+	}
+	else
+	{
+		unsigned int vertexShader = AddShader(vertexSource, GL_VERTEX_SHADER);
+		unsigned int fragmentShader = AddShader(fragmentSource, GL_FRAGMENT_SHADER);
 
-	// TODO: move the line below
-	// ensures the "(location = 0)" gets bound to its "position" name
-	glBindAttribLocation(m_shaderProgram, 0, "aPosition");
-	glBindAttribLocation(m_shaderProgram, 1, "aColor");
+		// ensures the "(location = 0)" gets bound to its "position" name, only applies before linking
+		glBindAttribLocation(m_shaderProgram, 0, "aPosition");
+		glBindAttribLocation(m_shaderProgram, 1, "aColor");
+		if (!cachePath.empty()) glProgramParameteri(m_shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+		glLinkProgram(m_shaderProgram);
+
+		GLint linkStatus = GL_FALSE;
+		glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &linkStatus);
+		m_linked = linkStatus == GL_TRUE;
+		if (!m_linked && m_error.empty())
+		{
+			char infoLog[1024] = "";
+			glGetProgramInfoLog(m_shaderProgram, sizeof(infoLog), NULL, infoLog);
+			m_error = "linking " + m_vertexFilePath + " + " + m_fragmentFilePath + " failed: " + infoLog;
+		}
+
+		// The program keeps what it needs, the shader objects can go
+		glDetachShader(m_shaderProgram, vertexShader);
+		glDetachShader(m_shaderProgram, fragmentShader);
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+
+		if (m_linked && !cachePath.empty()) SaveBinary(cachePath);
+	}
+
+	if (!m_error.empty()) std::cerr << "error: " << m_error << std::endl;
+
+	m_buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
 }
 
-ShaderProgram::~ShaderProgram()
+bool ShaderProgram::LoadBinary(const std::string& cachePath)
 {
+	std::ifstream fileStream(cachePath, std::ios::binary);
+	if (!fileStream) return false;
+
+	ProgramBinaryHeader header;
+	if (!fileStream.read((char*)&header, sizeof(header)) || std::memcmp(header.magic, programBinaryMagic, 4) != 0) return false;
+
+	// A corrupt length must not allocate gigabytes, the blob has to fit in what is left of the file
+	std::streamoff blobStart = fileStream.tellg();
+	fileStream.seekg(0, std::ios::end);
+	std::streamoff fileSize = fileStream.tellg();
+	if (blobStart < 0 || fileSize < blobStart || header.binaryLength == 0 ||
+		(uint64_t)header.binaryLength > (uint64_t)(fileSize - blobStart)) return false;
+	fileStream.seekg(blobStart);
+
+	std::vector<char> binary(header.binaryLength);
+	if (!fileStream.read(binary.data(), binary.size())) return false;
+
+	glProgramBinary(m_shaderProgram, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+
+	// A driver update makes old binaries fail here, the caller then recompiles and overwrites the file
+	GLint linkStatus = GL_FALSE;
+	glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &linkStatus);
+	return linkStatus == GL_TRUE;
 }
 
-unsigned int ShaderProgram::AddShader(const std::string& filePath, GLenum type)
+void ShaderProgram::SaveBinary(const std::string& cachePath)
 {
-	// Parse shader file to string
-	std::string shaderFileContent = ReadResourceFileToStr(filePath);
-	const char* shaderCodePtr = shaderFileContent.c_str();
+	GLint binaryLength = 0;
+	glGetProgramiv(m_shaderProgram, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+	if (binaryLength <= 0) return;
+
+	std::vector<char> binary(binaryLength);
+	GLenum binaryFormat = 0;
+	glGetProgramBinary(m_shaderProgram, binaryLength, NULL, &binaryFormat, binary.data());
+
+	ProgramBinaryHeader header;
+	std::memcpy(header.magic, programBinaryMagic, 4);
+	header.binaryFormat = binaryFormat;
+	header.binaryLength = (uint32_t)binaryLength;
+	header.reserved = 0;
+
+	createDirectory(s_binaryCacheDirectory);
+
+	// Written next to the target and renamed over it, a crash mid-write leaves no truncated entry behind
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream fileStream(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!fileStream) return;
+
+		fileStream.write((const char*)&header, sizeof(header));
+		fileStream.write(binary.data(), binary.size());
+		fileStream.close();
+		if (!fileStream) {
+			std::remove(temporaryPath.c_str());
+			return;
+		}
+	}
+
+#ifdef _WIN32
+	// rename does not replace an existing file on Windows
+	std::remove(cachePath.c_str());
+#endif
+	if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0) std::remove(temporaryPath.c_str());
+}
+
+unsigned int ShaderProgram::AddShader(const std::string& source, GLenum type)
+{
+	const char* shaderCodePtr = source.c_str();
 
 	// Create, assign and compile
 	unsigned int shader = glCreateShader(type);
 	glShaderSource(shader, 1, &shaderCodePtr, NULL);
 	glCompileShader(shader);
 
+	GLint compileStatus = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+	if (compileStatus != GL_TRUE && m_error.empty())
+	{
+		char infoLog[1024] = "";
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		m_error = "compiling " + (type == GL_VERTEX_SHADER ? m_vertexFilePath : m_fragmentFilePath) + " failed: " + infoLog;
+	}
+
 	glAttachShader(m_shaderProgram, shader);
 
 	return shader;
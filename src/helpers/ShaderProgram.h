@@ -1,24 +1,59 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <glew.h>
 
+class ShaderCompileQueue;
+
+// Vertex + fragment shader program.
+// Linked programs are kept on disk as driver binaries keyed by a hash of the sources and the driver strings,
+// later launches load them with glProgramBinary and only recompile when the driver rejects the binary.
 class ShaderProgram
 {
 public:
-	ShaderProgram(const std::string& vertexFilePath, const std::string& fragmentFilePath);
+	// Without a queue the program is built right away, with one it is built on the queue's worker context
+	// and must not be used before isReady()
+	ShaderProgram(const std::string& vertexFilePath, const std::string& fragmentFilePath, ShaderCompileQueue* compileQueue = nullptr);
 	~ShaderProgram();
 
+	// Where program binaries are kept, an empty path turns the cache off
+	static void SetBinaryCacheDirectory(const std::string& directory);
+
+	// Looked up once per name, the program has to be ready
+	int GetUniformLocation(const std::string& name);
+	// Points a uniform block of the program at a buffer binding point, no-op when the block is not used
+	void BindUniformBlock(const std::string& blockName, unsigned int bindingPoint);
+
 	inline const unsigned int getProgramId() { return m_shaderProgram; }
+	inline bool isReady() const { return m_ready; }
+	inline bool isLinked() const { return m_linked; }
+	inline bool wasLoadedFromCache() const { return m_loadedFromCache; }
+	inline double getBuildMs() const { return m_buildMs; }
+	inline const std::string& getError() const { return m_error; }
 private:
-	unsigned int AddShader(const std::string& filePath, GLenum type);
+	friend class ShaderCompileQueue;
+
+	// Reads, compiles (or loads) and links on the thread with the current context
+	void Build();
+	bool LoadBinary(const std::string& cachePath);
+	void SaveBinary(const std::string& cachePath);
+	unsigned int AddShader(const std::string& source, GLenum type);
 
 	std::string m_vertexFilePath = "";
 	std::string m_fragmentFilePath = "";
-
-	unsigned int m_vertexShader = 0;
-	unsigned int m_fragmentShader = 0;
+	ShaderCompileQueue* m_compileQueue = nullptr;
 
 	unsigned int m_shaderProgram = 0;
+	std::unordered_map<std::string, int> m_uniformLocations;
+
+	bool m_linked = false;
+	bool m_loadedFromCache = false;
+	double m_buildMs = 0.0;
+	std::string m_error = "";
+	// Set last, once everything above is written
+	std::atomic<bool> m_ready{ false };
+
+	static std::string s_binaryCacheDirectory;
 };
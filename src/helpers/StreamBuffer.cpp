@@ -0,0 +1,152 @@
+#include "StreamBuffer.h"
+
+#include <algorithm>
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+StreamBuffer::StreamBuffer(size_t segmentSize, size_t alignment, int segmentCount)
+	: m_alignment(std::max<size_t>(1, alignment)), m_segmentCount(std::min(std::max(1, segmentCount), maxSegmentCount))
+{
+	m_persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+	for (int segment = 0; segment < maxSegmentCount; segment++)
+		m_fences[segment] = nullptr;
+
+	Allocate(segmentSize);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	Release();
+}
+
+void StreamBuffer::Allocate(size_t segmentSize)
+{
+	m_segmentSize = alignUp(std::max<size_t>(1, segmentSize), m_alignment);
+	glGenBuffers(1, &m_buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+	if (m_persistent)
+	{
+		// Coherent, so writes need no flush and show up for draws issued after them
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		size_t size = m_segmentSize * m_segmentCount;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+		m_mapping = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+		if (!m_mapping)
+		{
+			// Immutable storage cannot be respecified, a new buffer streams the orphaning way from now on
+			glDeleteBuffers(1, &m_buffer);
+			glGenBuffers(1, &m_buffer);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+			m_persistent = false;
+		}
+	}
+	if (!m_persistent)
+	{
+		glBufferData(GL_COPY_WRITE_BUFFER, m_segmentSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	m_segment = 0;
+	m_offset = 0;
+}
+
+void StreamBuffer::Release()
+{
+	// Deleting a mapped buffer unmaps it, draws already submitted keep their storage alive
+	for (int segment = 0; segment < maxSegmentCount; segment++)
+	{
+		if (m_fences[segment]) glDeleteSync(m_fences[segment]);
+		m_fences[segment] = nullptr;
+	}
+	if (m_buffer) glDeleteBuffers(1, &m_buffer);
+	m_buffer = 0;
+	m_mapping = nullptr;
+}
+
+void StreamBuffer::WaitForSegment(int segment)
+{
+	GLsync fence = m_fences[segment];
+	if (!fence) return;
+
+	// Polled first, so only real waits count as stalls
+	GLenum result = glClientWaitSync(fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED)
+	{
+		m_stallCount++;
+		do
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	m_fences[segment] = nullptr;
+}
+
+void* StreamBuffer::Begin(size_t bytes)
+{
+	if (m_writing) End();
+
+	if (bytes > m_segmentSize)
+	{
+		// Grows to at least double, a count slider dragged upwards does not reallocate every frame
+		Release();
+		Allocate(std::max(bytes, m_segmentSize * 2));
+	}
+
+	m_writing = true;
+	m_bytesStreamed += bytes;
+
+	if (!m_persistent)
+	{
+		// Orphaning hands the old storage to the draws still reading it
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, m_segmentSize, nullptr, GL_STREAM_DRAW);
+		void* mapping = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, std::max<size_t>(1, bytes),
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_offset = 0;
+		if (!mapping)
+		{
+			// The driver refused the mapping, the data is copied in with glBufferSubData by End instead
+			m_staging.resize(std::max<size_t>(1, bytes));
+			m_stagingBytes = bytes;
+			m_staged = true;
+			return m_staging.data();
+		}
+		return mapping;
+	}
+
+	m_segment = (m_segment + 1) % m_segmentCount;
+	WaitForSegment(m_segment);
+	m_offset = (size_t)m_segment * m_segmentSize;
+	return m_mapping + m_offset;
+}
+
+void StreamBuffer::End()
+{
+	if (!m_writing) return;
+	m_writing = false;
+
+	if (!m_persistent)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		if (m_staged) glBufferSubData(GL_COPY_WRITE_BUFFER, 0, m_stagingBytes, m_staging.data());
+		else glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_staged = false;
+	}
+}
+
+void StreamBuffer::Fence()
+{
+	if (!m_persistent) return;
+
+	// Only the latest draws matter, an older fence of the same segment signals before them
+	if (m_fences[m_segment]) glDeleteSync(m_fences[m_segment]);
+	m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <glew.h>
+
+// Buffer for data rewritten every frame, split into segments the CPU fills in turn while the GPU reads the others.
+// With GL 4.4 (or ARB_buffer_storage) it is mapped once with GL_MAP_PERSISTENT_BIT and every segment gets a fence
+// after the draws reading it, so writing only waits when the GPU is a whole ring of frames behind.
+// Older contexts orphan and map the buffer on every Begin instead, the offset is then always 0.
+// A failed persistent mapping falls back to orphaning, a failed per-frame mapping to glBufferSubData from a CPU copy.
+// Needs a current OpenGL context.
+class StreamBuffer
+{
+public:
+	// Offsets of the segments are multiples of "alignment", e.g. the size of one element
+	StreamBuffer(size_t segmentSize, size_t alignment, int segmentCount = defaultSegmentCount);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// Moves to the next segment and returns where to write "bytes" of data, getOffset() is where they land in the buffer.
+	// Larger requests replace the buffer with bigger segments, check getBuffer() afterwards
+	void* Begin(size_t bytes);
+	// Done writing, has to come before the draws reading the data
+	void End();
+	// After the draws reading the current segment, it is not written again before they finished
+	void Fence();
+
+	inline unsigned int getBuffer() const { return m_buffer; }
+	inline size_t getOffset() const { return m_offset; }
+	inline size_t getSegmentSize() const { return m_segmentSize; }
+	inline bool isPersistent() const { return m_persistent; }
+	// Begin calls that had to wait for the GPU
+	inline unsigned int getStallCount() const { return m_stallCount; }
+	inline unsigned long long getBytesStreamed() const { return m_bytesStreamed; }
+
+	static const int defaultSegmentCount = 3;
+	static const int maxSegmentCount = 4;
+private:
+	void Allocate(size_t segmentSize);
+	void Release();
+	void WaitForSegment(int segment);
+
+	unsigned int m_buffer = 0;
+	size_t m_alignment;
+	size_t m_segmentSize = 0;
+	int m_segmentCount;
+	bool m_persistent = false;
+
+	char* m_mapping = nullptr;
+	GLsync m_fences[maxSegmentCount];
+	int m_segment = 0;
+	size_t m_offset = 0;
+	bool m_writing = false;
+
+	// Written instead of a mapping the driver refused, uploaded by End
+	std::vector<char> m_staging;
+	size_t m_stagingBytes = 0;
+	bool m_staged = false;
+
+	unsigned int m_stallCount = 0;
+	unsigned long long m_bytesStreamed = 0;
+};
@@ -0,0 +1,136 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Which pool and queue the current thread works for, submitting from a worker keeps the task local
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorkerIndex = 0;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_queues.emplace_back(new WorkerQueue());
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this, (size_t)i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stopping = true;
+	}
+	m_taskAvailable.notify_all();
+
+	for (std::thread& worker : m_workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	size_t queueIndex = currentPool == this ? currentWorkerIndex : m_nextQueue++ % m_queues.size();
+	{
+		// Counted before it is queued: a worker may pop it right after the push, and its decrement must not
+		// wrap the count around. Under the sleep lock so a worker about to wait cannot miss it
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_queuedTasks++;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+		m_queues[queueIndex]->tasks.push_back(std::move(task));
+	}
+	m_taskAvailable.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task)
+{
+	if (count == 0) return;
+
+	// Shared with the helper tasks, which may still be queued after this returns
+	struct Batch
+	{
+		std::atomic<size_t> nextIndex{ 0 };
+		std::atomic<size_t> finished{ 0 };
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+	const std::function<void(size_t)>* taskPtr = &task;
+
+	auto runIndices = [batch, taskPtr, count]()
+	{
+		for (size_t i = batch->nextIndex++; i < count; i = batch->nextIndex++)
+		{
+			(*taskPtr)(i);
+			if (++batch->finished == count)
+			{
+				std::lock_guard<std::mutex> lock(batch->mutex);
+				batch->done.notify_all();
+			}
+		}
+	};
+
+	size_t helperCount = std::min(count - 1, m_workers.size());
+	for (size_t i = 0; i < helperCount; i++)
+		Submit(runIndices);
+
+	runIndices();
+
+	std::unique_lock<std::mutex> lock(batch->mutex);
+	batch->done.wait(lock, [&batch, count]() { return batch->finished == count; });
+}
+
+bool ThreadPool::PopTask(size_t workerIndex, std::function<void()>& task)
+{
+	// Own queue from the back, still warm in cache
+	{
+		WorkerQueue& queue = *m_queues[workerIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// Others from the front, their oldest and usually largest pieces of work
+	for (size_t offset = 1; offset < m_queues.size(); offset++)
+	{
+		WorkerQueue& queue = *m_queues[(workerIndex + offset) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty())
+		{
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			m_stealCount++;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::WorkerLoop(size_t workerIndex)
+{
+	currentPool = this;
+	currentWorkerIndex = workerIndex;
+
+	for (;;)
+	{
+		std::function<void()> task;
+		if (PopTask(workerIndex, task))
+		{
+			m_queuedTasks--;
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_taskAvailable.wait(lock, [this]() { return m_stopping || m_queuedTasks > 0; });
+		if (m_stopping && m_queuedTasks == 0) return;
+	}
+}
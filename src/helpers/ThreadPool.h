@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each.
+// Workers run their own queue newest first and steal the oldest tasks of the others when it runs dry,
+// tasks submitted from inside a task stay on the submitting worker's queue.
+class ThreadPool
+{
+public:
+	// 0 threads means one per hardware thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> task);
+	// Runs task(0) .. task(count - 1) on the workers and the calling thread, returns once all of them ran.
+	// The caller helps, so this is safe to call from inside a task.
+	void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+	inline unsigned int getThreadCount() const { return (unsigned int)m_workers.size(); }
+	// Tasks taken from another worker's queue since the start, to see the balancing at work
+	inline unsigned int getStealCount() const { return m_stealCount; }
+private:
+	struct WorkerQueue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	void WorkerLoop(size_t workerIndex);
+	bool PopTask(size_t workerIndex, std::function<void()>& task);
+
+	std::vector<std::thread> m_workers;
+	std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+	std::atomic<size_t> m_nextQueue{ 0 };
+	std::atomic<size_t> m_queuedTasks{ 0 };
+	std::atomic<unsigned int> m_stealCount{ 0 };
+
+	// Only for sleeping workers, the queues have their own locks
+	std::mutex m_sleepMutex;
+	std::condition_variable m_taskAvailable;
+	bool m_stopping = false;
+};
@@ -0,0 +1,440 @@
+#include "TransformBatch.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define TRANSFORM_BATCH_SIMD 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang only emit AVX2 instructions in functions that ask for them, MSVC always allows the intrinsics
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+static const glm::vec3 rotationXAxis = glm::vec3(1.0f, 0.0f, 0.0f);
+static const glm::vec3 rotationYAxis = glm::vec3(0.0f, 1.0f, 0.0f);
+static const glm::vec3 rotationZAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+
+TransformBatch::TransformBatch()
+{
+}
+
+TransformBatch::~TransformBatch()
+{
+}
+
+void TransformBatch::Resize(size_t count)
+{
+	m_translationX.resize(count, 0.0f);
+	m_translationY.resize(count, 0.0f);
+	m_translationZ.resize(count, 0.0f);
+	m_rotationX.resize(count, 0.0f);
+	m_rotationY.resize(count, 0.0f);
+	m_rotationZ.resize(count, 0.0f);
+	m_scaleX.resize(count, 1.0f);
+	m_scaleY.resize(count, 1.0f);
+	m_scaleZ.resize(count, 1.0f);
+}
+
+void TransformBatch::Clear()
+{
+	Resize(0);
+}
+
+size_t TransformBatch::Add(const glm::vec3& translation, const glm::vec3& rotationDegrees, const glm::vec3& scale)
+{
+	size_t index = size();
+	Resize(index + 1);
+	SetTranslation(index, translation);
+	SetRotation(index, rotationDegrees);
+	SetScale(index, scale);
+
+	return index;
+}
+
+void TransformBatch::SetTranslation(size_t index, const glm::vec3& translation)
+{
+	m_translationX[index] = translation.x;
+	m_translationY[index] = translation.y;
+	m_translationZ[index] = translation.z;
+}
+
+void TransformBatch::SetRotation(size_t index, const glm::vec3& rotationDegrees)
+{
+	m_rotationX[index] = glm::radians(rotationDegrees.x);
+	m_rotationY[index] = glm::radians(rotationDegrees.y);
+	m_rotationZ[index] = glm::radians(rotationDegrees.z);
+}
+
+void TransformBatch::SetScale(size_t index, const glm::vec3& scale)
+{
+	m_scaleX[index] = scale.x;
+	m_scaleY[index] = scale.y;
+	m_scaleZ[index] = scale.z;
+}
+
+void TransformBatch::AddRotationToAll(const glm::vec3& rotationDegrees)
+{
+	AddRotation(rotationDegrees, 0, size());
+}
+
+void TransformBatch::AddRotation(const glm::vec3& rotationDegrees, size_t first, size_t last)
+{
+	const float twoPi = 6.28318530717958647692f;
+	float deltas[3] = { glm::radians(rotationDegrees.x), glm::radians(rotationDegrees.y), glm::radians(rotationDegrees.z) };
+	std::vector<float>* angles[3] = { &m_rotationX, &m_rotationY, &m_rotationZ };
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (deltas[axis] == 0.0f) continue;
+		// Wrap so long running animations keep the angles in the range the SIMD sin/cos is accurate for
+		float* axisAngles = angles[axis]->data();
+		for (size_t i = first; i < last; i++)
+		{
+			float& angle = axisAngles[i];
+			angle += deltas[axis];
+			if (angle > twoPi) angle -= twoPi;
+			else if (angle < -twoPi) angle += twoPi;
+		}
+	}
+}
+
+glm::vec3 TransformBatch::GetTranslation(size_t index) const
+{
+	return glm::vec3(m_translationX[index], m_translationY[index], m_translationZ[index]);
+}
+
+void TransformBatch::ComputeModelMatrices(glm::mat4* output, TransformKernel kernel) const
+{
+	Compute(glm::mat4(1.0f), output, 0, size(), kernel);
+}
+
+void TransformBatch::ComputeModelMatrices(glm::mat4* output, size_t first, size_t last, TransformKernel kernel) const
+{
+	Compute(glm::mat4(1.0f), output, first, last, kernel);
+}
+
+void TransformBatch::ComputeModelViewProjections(const glm::mat4& viewProjection, glm::mat4* output, TransformKernel kernel) const
+{
+	Compute(viewProjection, output, 0, size(), kernel);
+}
+
+static bool cpuSupportsAvx2()
+{
+#if !defined(TRANSFORM_BATCH_SIMD)
+	return false;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+
+	// AVX needs both the CPU and the OS (saving the YMM registers) to support it
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+TransformKernel TransformBatch::GetBestKernel()
+{
+	static const TransformKernel bestKernel =
+#ifdef TRANSFORM_BATCH_SIMD
+		cpuSupportsAvx2() ? TransformKernel::Avx2 : TransformKernel::Sse;
+#else
+		TransformKernel::Scalar;
+#endif
+	return bestKernel;
+}
+
+const char* TransformBatch::GetKernelName(TransformKernel kernel)
+{
+	switch (kernel)
+	{
+	case TransformKernel::Auto: return GetKernelName(GetBestKernel());
+	case TransformKernel::Scalar: return "scalar";
+	case TransformKernel::Sse: return "sse";
+	case TransformKernel::Avx2: return "avx2";
+	}
+	return "unknown";
+}
+
+void TransformBatch::Compute(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last, TransformKernel kernel) const
+{
+	if (kernel == TransformKernel::Auto) kernel = GetBestKernel();
+#ifndef TRANSFORM_BATCH_SIMD
+	kernel = TransformKernel::Scalar;
+#endif
+
+	size_t simdLast = first;
+
+	if (kernel == TransformKernel::Avx2)
+	{
+		simdLast = first + ((last - first) & ~(size_t)7);
+		ComputeAvx2(viewProjection, output, first, simdLast);
+	}
+	else if (kernel == TransformKernel::Sse)
+	{
+		simdLast = first + ((last - first) & ~(size_t)3);
+		ComputeSse(viewProjection, output, first, simdLast);
+	}
+
+	// Whatever does not fill a whole SIMD register
+	ComputeScalar(viewProjection, output, simdLast, last);
+}
+
+void TransformBatch::ComputeScalar(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const
+{
+	for (size_t i = first; i < last; i++)
+	{
+		glm::mat4 rotationMatrix = glm::mat4(1.0f);
+		rotationMatrix = glm::rotate(rotationMatrix, m_rotationX[i], rotationXAxis);
+		rotationMatrix = glm::rotate(rotationMatrix, m_rotationY[i], rotationYAxis);
+		rotationMatrix = glm::rotate(rotationMatrix, m_rotationZ[i], rotationZAxis);
+		glm::mat4 translateMatrix = glm::translate(glm::mat4(1.0f), GetTranslation(i));
+		glm::mat4 scaleMatrix = glm::scale(glm::mat4(1.0f), glm::vec3(m_scaleX[i], m_scaleY[i], m_scaleZ[i]));
+
+		output[i] = viewProjection * translateMatrix * rotationMatrix * scaleMatrix;
+	}
+}
+
+#ifdef TRANSFORM_BATCH_SIMD
+
+// sin/cos of 4 angles: quadrant reduction with a two part pi/2 then minimax polynomials on [-pi/4, pi/4].
+// Accurate to a few ulp for |angle| up to a few turns, which is all the batch ever holds.
+static inline void sinCosSse(__m128 angle, __m128& sinOut, __m128& cosOut)
+{
+	const __m128 twoOverPi = _mm_set1_ps(0.63661977236758134308f);
+	const __m128 piOverTwoHigh = _mm_set1_ps(1.5707963705062866f);
+	const __m128 piOverTwoLow = _mm_set1_ps(-4.371139000186241e-08f);
+
+	__m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(angle, twoOverPi));
+	__m128 quadrantFloat = _mm_cvtepi32_ps(quadrant);
+	__m128 r = _mm_sub_ps(angle, _mm_mul_ps(quadrantFloat, piOverTwoHigh));
+	r = _mm_sub_ps(r, _mm_mul_ps(quadrantFloat, piOverTwoLow));
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 sinR = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(r2, _mm_set1_ps(-1.9515295891e-4f)));
+	sinR = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(r2, sinR));
+	sinR = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r2, r), sinR));
+
+	__m128 cosR = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(r2, _mm_set1_ps(2.443315711809948e-5f)));
+	cosR = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(r2, cosR));
+	cosR = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(r2, _mm_set1_ps(0.5f))), _mm_mul_ps(_mm_mul_ps(r2, r2), cosR));
+
+	// Odd quadrants swap sin and cos, quadrants 2-3 negate sin and 1-2 negate cos
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+	__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+	sinOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, cosR), _mm_andnot_ps(swap, sinR)), sinSign);
+	cosOut = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, sinR), _mm_andnot_ps(swap, cosR)), cosSign);
+}
+
+// Four registers each holding one matrix component for 4 objects -> one vec4 column per object
+static inline void storeColumnsSse(__m128 x, __m128 y, __m128 z, __m128 w, glm::mat4* output, int column)
+{
+	_MM_TRANSPOSE4_PS(x, y, z, w);
+	_mm_storeu_ps(&output[0][column][0], x);
+	_mm_storeu_ps(&output[1][column][0], y);
+	_mm_storeu_ps(&output[2][column][0], z);
+	_mm_storeu_ps(&output[3][column][0], w);
+}
+
+void TransformBatch::ComputeSse(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const
+{
+	bool applyViewProjection = viewProjection != glm::mat4(1.0f);
+	__m128 vp[4][4];
+	for (int column = 0; column < 4; column++)
+		for (int row = 0; row < 4; row++)
+			vp[column][row] = _mm_set1_ps(viewProjection[column][row]);
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (size_t i = first; i < last; i += 4)
+	{
+		__m128 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		sinCosSse(_mm_loadu_ps(&m_rotationX[i]), sinX, cosX);
+		sinCosSse(_mm_loadu_ps(&m_rotationY[i]), sinY, cosY);
+		sinCosSse(_mm_loadu_ps(&m_rotationZ[i]), sinZ, cosZ);
+
+		// rotateX * rotateY * rotateZ written out, R[row][column]
+		__m128 sinXsinY = _mm_mul_ps(sinX, sinY);
+		__m128 cosXsinY = _mm_mul_ps(cosX, sinY);
+		__m128 r00 = _mm_mul_ps(cosY, cosZ);
+		__m128 r01 = _mm_sub_ps(zero, _mm_mul_ps(cosY, sinZ));
+		__m128 r02 = sinY;
+		__m128 r10 = _mm_add_ps(_mm_mul_ps(sinXsinY, cosZ), _mm_mul_ps(cosX, sinZ));
+		__m128 r11 = _mm_sub_ps(_mm_mul_ps(cosX, cosZ), _mm_mul_ps(sinXsinY, sinZ));
+		__m128 r12 = _mm_sub_ps(zero, _mm_mul_ps(sinX, cosY));
+		__m128 r20 = _mm_sub_ps(_mm_mul_ps(sinX, sinZ), _mm_mul_ps(cosXsinY, cosZ));
+		__m128 r21 = _mm_add_ps(_mm_mul_ps(cosXsinY, sinZ), _mm_mul_ps(sinX, cosZ));
+		__m128 r22 = _mm_mul_ps(cosX, cosY);
+
+		// Model columns: rotation scaled per axis, then translation
+		__m128 scaleX = _mm_loadu_ps(&m_scaleX[i]);
+		__m128 scaleY = _mm_loadu_ps(&m_scaleY[i]);
+		__m128 scaleZ = _mm_loadu_ps(&m_scaleZ[i]);
+		__m128 model[4][4] = {
+			{ _mm_mul_ps(r00, scaleX), _mm_mul_ps(r10, scaleX), _mm_mul_ps(r20, scaleX), zero },
+			{ _mm_mul_ps(r01, scaleY), _mm_mul_ps(r11, scaleY), _mm_mul_ps(r21, scaleY), zero },
+			{ _mm_mul_ps(r02, scaleZ), _mm_mul_ps(r12, scaleZ), _mm_mul_ps(r22, scaleZ), zero },
+			{ _mm_loadu_ps(&m_translationX[i]), _mm_loadu_ps(&m_translationY[i]), _mm_loadu_ps(&m_translationZ[i]), one },
+		};
+
+		for (int column = 0; column < 4; column++)
+		{
+			__m128 result[4];
+			for (int row = 0; row < 4; row++)
+			{
+				if (!applyViewProjection)
+				{
+					result[row] = model[column][row];
+					continue;
+				}
+				result[row] = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(vp[0][row], model[column][0]), _mm_mul_ps(vp[1][row], model[column][1])),
+					_mm_add_ps(_mm_mul_ps(vp[2][row], model[column][2]), _mm_mul_ps(vp[3][row], model[column][3]))
+				);
+			}
+			storeColumnsSse(result[0], result[1], result[2], result[3], output + i, column);
+		}
+	}
+}
+
+TARGET_AVX2 static inline void sinCosAvx2(__m256 angle, __m256& sinOut, __m256& cosOut)
+{
+	const __m256 twoOverPi = _mm256_set1_ps(0.63661977236758134308f);
+	const __m256 piOverTwoHigh = _mm256_set1_ps(1.5707963705062866f);
+	const __m256 piOverTwoLow = _mm256_set1_ps(-4.371139000186241e-08f);
+
+	__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(angle, twoOverPi));
+	__m256 quadrantFloat = _mm256_cvtepi32_ps(quadrant);
+	__m256 r = _mm256_sub_ps(angle, _mm256_mul_ps(quadrantFloat, piOverTwoHigh));
+	r = _mm256_sub_ps(r, _mm256_mul_ps(quadrantFloat, piOverTwoLow));
+	__m256 r2 = _mm256_mul_ps(r, r);
+
+	__m256 sinR = _mm256_add_ps(_mm256_set1_ps(8.3321608736e-3f), _mm256_mul_ps(r2, _mm256_set1_ps(-1.9515295891e-4f)));
+	sinR = _mm256_add_ps(_mm256_set1_ps(-1.6666654611e-1f), _mm256_mul_ps(r2, sinR));
+	sinR = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r2, r), sinR));
+
+	__m256 cosR = _mm256_add_ps(_mm256_set1_ps(-1.388731625493765e-3f), _mm256_mul_ps(r2, _mm256_set1_ps(2.443315711809948e-5f)));
+	cosR = _mm256_add_ps(_mm256_set1_ps(4.166664568298827e-2f), _mm256_mul_ps(r2, cosR));
+	cosR = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(r2, _mm256_set1_ps(0.5f))), _mm256_mul_ps(_mm256_mul_ps(r2, r2), cosR));
+
+	__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+	__m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+	__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+	sinOut = _mm256_xor_ps(_mm256_blendv_ps(sinR, cosR, swap), sinSign);
+	cosOut = _mm256_xor_ps(_mm256_blendv_ps(cosR, sinR, swap), cosSign);
+}
+
+// Same as storeColumnsSse for 8 objects: transpose both 128 bit halves at once
+TARGET_AVX2 static inline void storeColumnsAvx2(__m256 x, __m256 y, __m256 z, __m256 w, glm::mat4* output, int column)
+{
+	__m256 xyLow = _mm256_unpacklo_ps(x, y);
+	__m256 xyHigh = _mm256_unpackhi_ps(x, y);
+	__m256 zwLow = _mm256_unpacklo_ps(z, w);
+	__m256 zwHigh = _mm256_unpackhi_ps(z, w);
+	__m256 objects[4] = {
+		_mm256_shuffle_ps(xyLow, zwLow, 0x44), // objects 0 and 4
+		_mm256_shuffle_ps(xyLow, zwLow, 0xEE), // objects 1 and 5
+		_mm256_shuffle_ps(xyHigh, zwHigh, 0x44), // objects 2 and 6
+		_mm256_shuffle_ps(xyHigh, zwHigh, 0xEE), // objects 3 and 7
+	};
+
+	for (int i = 0; i < 4; i++)
+	{
+		_mm_storeu_ps(&output[i][column][0], _mm256_castps256_ps128(objects[i]));
+		_mm_storeu_ps(&output[i + 4][column][0], _mm256_extractf128_ps(objects[i], 1));
+	}
+}
+
+TARGET_AVX2 void TransformBatch::ComputeAvx2(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const
+{
+	bool applyViewProjection = viewProjection != glm::mat4(1.0f);
+	__m256 vp[4][4];
+	for (int column = 0; column < 4; column++)
+		for (int row = 0; row < 4; row++)
+			vp[column][row] = _mm256_set1_ps(viewProjection[column][row]);
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	for (size_t i = first; i < last; i += 8)
+	{
+		__m256 sinX, cosX, sinY, cosY, sinZ, cosZ;
+		sinCosAvx2(_mm256_loadu_ps(&m_rotationX[i]), sinX, cosX);
+		sinCosAvx2(_mm256_loadu_ps(&m_rotationY[i]), sinY, cosY);
+		sinCosAvx2(_mm256_loadu_ps(&m_rotationZ[i]), sinZ, cosZ);
+
+		// rotateX * rotateY * rotateZ written out, R[row][column]
+		__m256 sinXsinY = _mm256_mul_ps(sinX, sinY);
+		__m256 cosXsinY = _mm256_mul_ps(cosX, sinY);
+		__m256 r00 = _mm256_mul_ps(cosY, cosZ);
+		__m256 r01 = _mm256_sub_ps(zero, _mm256_mul_ps(cosY, sinZ));
+		__m256 r02 = sinY;
+		__m256 r10 = _mm256_add_ps(_mm256_mul_ps(sinXsinY, cosZ), _mm256_mul_ps(cosX, sinZ));
+		__m256 r11 = _mm256_sub_ps(_mm256_mul_ps(cosX, cosZ), _mm256_mul_ps(sinXsinY, sinZ));
+		__m256 r12 = _mm256_sub_ps(zero, _mm256_mul_ps(sinX, cosY));
+		__m256 r20 = _mm256_sub_ps(_mm256_mul_ps(sinX, sinZ), _mm256_mul_ps(cosXsinY, cosZ));
+		__m256 r21 = _mm256_add_ps(_mm256_mul_ps(cosXsinY, sinZ), _mm256_mul_ps(sinX, cosZ));
+		__m256 r22 = _mm256_mul_ps(cosX, cosY);
+
+		// Model columns: rotation scaled per axis, then translation
+		__m256 scaleX = _mm256_loadu_ps(&m_scaleX[i]);
+		__m256 scaleY = _mm256_loadu_ps(&m_scaleY[i]);
+		__m256 scaleZ = _mm256_loadu_ps(&m_scaleZ[i]);
+		__m256 model[4][4] = {
+			{ _mm256_mul_ps(r00, scaleX), _mm256_mul_ps(r10, scaleX), _mm256_mul_ps(r20, scaleX), zero },
+			{ _mm256_mul_ps(r01, scaleY), _mm256_mul_ps(r11, scaleY), _mm256_mul_ps(r21, scaleY), zero },
+			{ _mm256_mul_ps(r02, scaleZ), _mm256_mul_ps(r12, scaleZ), _mm256_mul_ps(r22, scaleZ), zero },
+			{ _mm256_loadu_ps(&m_translationX[i]), _mm256_loadu_ps(&m_translationY[i]), _mm256_loadu_ps(&m_translationZ[i]), one },
+		};
+
+		for (int column = 0; column < 4; column++)
+		{
+			__m256 result[4];
+			for (int row = 0; row < 4; row++)
+			{
+				if (!applyViewProjection)
+				{
+					result[row] = model[column][row];
+					continue;
+				}
+				result[row] = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(vp[0][row], model[column][0]), _mm256_mul_ps(vp[1][row], model[column][1])),
+					_mm256_add_ps(_mm256_mul_ps(vp[2][row], model[column][2]), _mm256_mul_ps(vp[3][row], model[column][3]))
+				);
+			}
+			storeColumnsAvx2(result[0], result[1], result[2], result[3], output + i, column);
+		}
+	}
+}
+
+#else
+
+void TransformBatch::ComputeSse(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const
+{
+	ComputeScalar(viewProjection, output, first, last);
+}
+
+void TransformBatch::ComputeAvx2(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const
+{
+	ComputeScalar(viewProjection, output, first, last);
+}
+
+#endif
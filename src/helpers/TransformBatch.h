@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Which implementation composes the matrices, Auto picks the widest one the CPU supports
+enum class TransformKernel
+{
+	Auto,
+	Scalar, // glm::translate/rotate/scale chain, the reference the SIMD kernels are compared against
+	Sse,    // 4 objects per iteration
+	Avx2    // 8 objects per iteration
+};
+
+// Translation/Euler rotation/scale of many objects stored as structure of arrays,
+// so whole batches of model (or model-view-projection) matrices can be composed with SIMD.
+// model = translate * rotateX * rotateY * rotateZ * scale, same order as the single object in Scene.
+class TransformBatch
+{
+public:
+	TransformBatch();
+	~TransformBatch();
+
+	void Resize(size_t count);
+	void Clear();
+	size_t Add(const glm::vec3& translation, const glm::vec3& rotationDegrees, const glm::vec3& scale);
+
+	void SetTranslation(size_t index, const glm::vec3& translation);
+	void SetRotation(size_t index, const glm::vec3& rotationDegrees);
+	void SetScale(size_t index, const glm::vec3& scale);
+	// Adds the same rotation to every object, cheap per-frame animation
+	void AddRotationToAll(const glm::vec3& rotationDegrees);
+	// Same for objects [first, last), disjoint ranges can run on different threads
+	void AddRotation(const glm::vec3& rotationDegrees, size_t first, size_t last);
+
+	glm::vec3 GetTranslation(size_t index) const;
+
+	// "output" must hold size() matrices
+	void ComputeModelMatrices(glm::mat4* output, TransformKernel kernel = TransformKernel::Auto) const;
+	// Only writes output[first] .. output[last - 1]
+	void ComputeModelMatrices(glm::mat4* output, size_t first, size_t last, TransformKernel kernel = TransformKernel::Auto) const;
+	void ComputeModelViewProjections(const glm::mat4& viewProjection, glm::mat4* output, TransformKernel kernel = TransformKernel::Auto) const;
+
+	static TransformKernel GetBestKernel();
+	static const char* GetKernelName(TransformKernel kernel);
+
+	inline size_t size() const { return m_translationX.size(); }
+private:
+	void ComputeScalar(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const;
+	void ComputeSse(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const;
+	void ComputeAvx2(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last) const;
+	void Compute(const glm::mat4& viewProjection, glm::mat4* output, size_t first, size_t last, TransformKernel kernel) const;
+
+	std::vector<float> m_translationX, m_translationY, m_translationZ;
+	// radians
+	std::vector<float> m_rotationX, m_rotationY, m_rotationZ;
+	std::vector<float> m_scaleX, m_scaleY, m_scaleZ;
+};
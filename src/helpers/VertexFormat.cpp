@@ -0,0 +1,116 @@
+#include "VertexFormat.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
+
+// Compact layout: three 16-bit position components, 2 bytes padding so the color is 4 byte aligned, RGBA8 color
+struct CompactVertex
+{
+	uint16_t position[3];
+	uint16_t padding;
+	uint32_t color;
+};
+static_assert(sizeof(CompactVertex) == 12, "CompactVertex must stay tightly packed");
+
+void PackMesh(const float* vertexData, unsigned int vertexCount, const uint32_t* indexData, unsigned int indexCount,
+	const glm::vec3& boundsMin, const glm::vec3& boundsMax, VertexFormat format, PackedMesh& packed)
+{
+	packed.format = format;
+	packed.vertexCount = vertexCount;
+	packed.indexCount = indexCount;
+
+	if (format == VertexFormat::Float32)
+	{
+		packed.vertexData.resize((size_t)vertexCount * GetVertexStride(format));
+		if (vertexCount > 0) std::memcpy(packed.vertexData.data(), vertexData, packed.vertexData.size());
+		packed.decodeMatrix = glm::mat4(1.0f);
+	}
+	else
+	{
+		// Positions are stored relative to the bounds so the 16 bits cover the mesh and nothing else
+		glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+		glm::vec3 halfExtent = (boundsMax - boundsMin) * 0.5f;
+		for (int axis = 0; axis < 3; axis++)
+			if (halfExtent[axis] <= 0.0f) halfExtent[axis] = 1.0f;
+		packed.decodeMatrix = glm::translate(glm::mat4(1.0f), center) * glm::scale(glm::mat4(1.0f), halfExtent);
+
+		packed.vertexData.resize((size_t)vertexCount * sizeof(CompactVertex));
+		CompactVertex* vertices = (CompactVertex*)packed.vertexData.data();
+		for (unsigned int i = 0; i < vertexCount; i++)
+		{
+			const float* source = vertexData + (size_t)i * 6;
+			CompactVertex& vertex = vertices[i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float normalized = (source[axis] - center[axis]) / halfExtent[axis];
+				vertex.position[axis] = format == VertexFormat::HalfFloat ? glm::packHalf1x16(normalized) : glm::packSnorm1x16(normalized);
+			}
+			vertex.padding = 0;
+			vertex.color = glm::packUnorm4x8(glm::vec4(source[3], source[4], source[5], 1.0f));
+		}
+	}
+
+	if (vertexCount <= maxShortIndexVertexCount)
+	{
+		packed.indexType = GL_UNSIGNED_SHORT;
+		packed.indexData.resize((size_t)indexCount * sizeof(uint16_t));
+		uint16_t* indices = (uint16_t*)packed.indexData.data();
+		for (unsigned int i = 0; i < indexCount; i++)
+			indices[i] = (uint16_t)indexData[i];
+	}
+	else
+	{
+		packed.indexType = GL_UNSIGNED_INT;
+		packed.indexData.resize((size_t)indexCount * sizeof(uint32_t));
+		if (indexCount > 0) std::memcpy(packed.indexData.data(), indexData, packed.indexData.size());
+	}
+}
+
+void SetupVertexAttributes(VertexFormat format)
+{
+	GLsizei stride = (GLsizei)GetVertexStride(format);
+	switch (format)
+	{
+	case VertexFormat::HalfFloat:
+		glVertexAttribPointer(0, 3, GL_HALF_FLOAT, GL_FALSE, stride, (void*)0);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(CompactVertex, color));
+		break;
+	case VertexFormat::Snorm16:
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(CompactVertex, color));
+		break;
+	default:
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(3 * sizeof(float)));
+		break;
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+}
+
+size_t GetVertexStride(VertexFormat format)
+{
+	return format == VertexFormat::Float32 ? 6 * sizeof(float) : sizeof(CompactVertex);
+}
+
+const char* GetVertexFormatName(VertexFormat format)
+{
+	switch (format)
+	{
+	case VertexFormat::HalfFloat: return "half";
+	case VertexFormat::Snorm16: return "snorm16";
+	default: return "float";
+	}
+}
+
+bool ParseVertexFormat(const std::string& name, VertexFormat& format)
+{
+	if (name == "float") format = VertexFormat::Float32;
+	else if (name == "half") format = VertexFormat::HalfFloat;
+	else if (name == "snorm16") format = VertexFormat::Snorm16;
+	else return false;
+	return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <glew.h>
+#include <glm/glm.hpp>
+
+// GPU side vertex layouts for meshes, the source data is always position xyz + color rgb as floats
+enum class VertexFormat
+{
+	Float32,    // 24 bytes: position and color as floats, uploaded as is
+	HalfFloat,  // 12 bytes: half float position scaled into [-1, 1] + RGBA8 color
+	Snorm16,    // 12 bytes: normalized int16 position scaled into [-1, 1] + RGBA8 color
+};
+
+// Mesh converted to a vertex format, with 16-bit indices when every vertex can be addressed with them
+struct PackedMesh
+{
+	VertexFormat format = VertexFormat::Float32;
+	std::vector<uint8_t> vertexData;
+	std::vector<uint8_t> indexData;
+	unsigned int vertexCount = 0;
+	unsigned int indexCount = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+	// Takes the stored positions back to mesh space, identity for Float32
+	glm::mat4 decodeMatrix = glm::mat4(1.0f);
+};
+
+// Fills "packed" from interleaved position + color floats, bounds are the ones of the positions
+void PackMesh(const float* vertexData, unsigned int vertexCount, const uint32_t* indexData, unsigned int indexCount,
+	const glm::vec3& boundsMin, const glm::vec3& boundsMax, VertexFormat format, PackedMesh& packed);
+
+// Attributes 0 (position) and 1 (color) for the vertex buffer bound to GL_ARRAY_BUFFER
+void SetupVertexAttributes(VertexFormat format);
+
+size_t GetVertexStride(VertexFormat format);
+const char* GetVertexFormatName(VertexFormat format);
+// "float", "half" or "snorm16", false for anything else
+bool ParseVertexFormat(const std::string& name, VertexFormat& format);
+
+// Vertices a 16-bit index buffer can address
+static const unsigned int maxShortIndexVertexCount = 65536;
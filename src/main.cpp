@@ -1,4 +1,14 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "external/imgui/imgui.h"
 #include "external/imgui/imgui_impl_glfw_gl3.h"
@@ -7,7 +17,23 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "helpers/FontAtlasCache.h"
+#include "helpers/FrameCapture.h"
+#include "helpers/FrameStats.h"
+#include "helpers/HeadlessContext.h"
+#include "helpers/InputRecording.h"
+#include "helpers/MatrixCache.h"
+#include "helpers/MeshFile.h"
+#include "helpers/MeshImportJob.h"
+#include "helpers/MeshImporter.h"
+#include "helpers/Profiler.h"
+#include "helpers/Scene.h"
+#include "helpers/SceneControls.h"
+#include "helpers/ShaderCompileQueue.h"
 #include "helpers/ShaderProgram.h"
+#include "helpers/ThreadPool.h"
+#include "helpers/TransformBatch.h"
+#include "helpers/VertexFormat.h"
 
 void frameBufferSizeCallback(GLFWwindow* window, int width, int height);
 
@@ -19,311 +45,1067 @@ static void logString(const char* message)
 int width = 1280;
 int height = 720;
 
-float vertices[48] = {
-	//     position    |          color
-	-0.5f, -0.5f, -0.5f,	1.0f, 0.0f, 0.0f, // front - bottom left
-	0.5f, -0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - bottom right
-	0.5f, 0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - top right
-	-0.5, 0.5f, -0.5f,		1.0f, 0.0f, 0.0f, // front - top left
-	-0.5f, -0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - bottom left
-	0.5f, -0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - bottom right
-	0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - top right
-	-0.5f, 0.5f, 0.5f,		0.0f, 1.0f, 0.0f, // back - top left
+// Event driven loop: when nothing changed, block in glfwWaitEvents instead of redrawing the same frame
+struct RenderLoopState
+{
+	bool idleWhenUnchanged = true;
+	// Set by the GLFW callbacks
+	bool inputEventPending = true;
+	// ImGui needs a few frames after an input to settle hover/active states
+	int framesToRender = 0;
+	unsigned int renderedFrames = 0;
+	unsigned int skippedFrames = 0;
 };
 
-unsigned int indices[36] = {
-	0, 1, 2, 0, 2, 3, // front face
-	4, 0, 3, 4, 7, 3, // left face
-	4, 5, 6, 4, 7, 6, // back face
-	1, 5, 6, 1, 2, 6, // right face
-	2, 3, 6, 3, 7, 6, // top face
-	0, 1, 5, 1, 4, 5, // bottom face
-};
+static const int framesAfterInput = 3;
+static RenderLoopState renderLoop;
+// Set while --record runs, the callbacks log into it
+static InputRecorder* inputRecorder = nullptr;
 
-float prismVertices[24] = {
-	//		position      |      colors
-	-0.3f, -0.6f, 0.0f,		1.0f, 0.0f, 0.0f, // front - bottom left
-	0.3f, -0.6f, 0.0f,		0.0f, 1.0f, 0.0f, // front - bottom right
-	0.0f, 0.6f, 0.0f,		0.0f, 0.0f, 1.0f, // front - top
-	0.0f, -0.6f, -0.5f,		0.5f, 0.0f, 0.5f, // back
-};
+static void markInputEvent()
+{
+	renderLoop.inputEventPending = true;
+}
+
+static void recordInputEvent(InputEventType type, int a, int b = 0, int c = 0, int d = 0, float x = 0.0f, float y = 0.0f)
+{
+	if (!inputRecorder) return;
+
+	InputEvent event;
+	event.type = type;
+	event.a = a;
+	event.b = b;
+	event.c = c;
+	event.d = d;
+	event.x = x;
+	event.y = y;
+	inputRecorder->AddEvent(event);
+}
+
+static void cursorPosCallback(GLFWwindow*, double xpos, double ypos)
+{
+	recordInputEvent(InputEventType::CursorPos, 0, 0, 0, 0, (float)xpos, (float)ypos);
+	markInputEvent();
+}
 
-unsigned int prismIndices[12] = {
-	0, 1, 2, // front face
-	0, 1, 3, // bottom face
-	0, 2, 3, // left face
-	1, 2, 3, // right face
+static void windowRefreshCallback(GLFWwindow*) { markInputEvent(); }
+
+static void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods)
+{
+	ImGui_ImplGlfw_MouseButtonCallback(window, button, action, mods);
+	recordInputEvent(InputEventType::MouseButton, button, action, mods);
+	markInputEvent();
+}
+
+static void scrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+{
+	ImGui_ImplGlfw_ScrollCallback(window, xoffset, yoffset);
+	recordInputEvent(InputEventType::Scroll, 0, 0, 0, 0, (float)xoffset, (float)yoffset);
+	markInputEvent();
+}
+
+static void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	ImGui_ImplGlfw_KeyCallback(window, key, scancode, action, mods);
+	recordInputEvent(InputEventType::Key, key, scancode, action, mods);
+	markInputEvent();
+}
+
+static void charCallback(GLFWwindow* window, unsigned int c)
+{
+	ImGui_ImplGlfw_CharCallback(window, c);
+	recordInputEvent(InputEventType::Char, (int)c);
+	markInputEvent();
+}
+
+// Command line, e.g. "MatricesVisualizer --headless --frames 1000 --output bench.json"
+struct LaunchOptions
+{
+	bool headless = false;
+	bool vsync = true;
+	int frames = 0;
+	double seconds = 0.0;
+	int instances = 0;
+	int transformBenchmarkCount = 0;
+	std::string meshPath = "";
+	std::string convertInputPath = "";
+	std::string convertOutputPath = "";
+	std::string outputPath = "";
+	bool asyncShaders = false;
+	bool shaderCache = true;
+	bool fontCache = true;
+	bool frustumCulling = true;
+	std::string tracePath = "";
+	bool imguiStreaming = false;
+	bool multiDrawIndirect = true;
+	VertexFormat meshVertexFormat = VertexFormat::Float32;
+	std::string recordPath = "";
+	std::string replayPath = "";
+	std::string frameTimesPath = "";
+	std::string captureDirectory = "";
+	CaptureFormat captureFormat = CaptureFormat::Png;
 };
 
-int main()
+static bool parseLaunchOptions(int argc, char** argv, LaunchOptions& options)
 {
-	// Create window
-	GLFWwindow* window;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+		bool hasValue = i + 1 < argc;
 
-	if (!glfwInit()) {
-		logString("GLFW could not initialize");
+		if (argument == "--headless") options.headless = true;
+		else if (argument == "--no-vsync") options.vsync = false;
+		else if (argument == "--frames" && hasValue) options.frames = std::atoi(argv[++i]);
+		else if (argument == "--seconds" && hasValue) options.seconds = std::atof(argv[++i]);
+		else if (argument == "--width" && hasValue) width = std::atoi(argv[++i]);
+		else if (argument == "--height" && hasValue) height = std::atoi(argv[++i]);
+		else if (argument == "--instances" && hasValue) options.instances = std::atoi(argv[++i]);
+		else if (argument == "--transform-bench" && hasValue) options.transformBenchmarkCount = std::atoi(argv[++i]);
+		else if (argument == "--mesh" && hasValue) options.meshPath = argv[++i];
+		else if (argument == "--convert" && i + 2 < argc)
+		{
+			options.convertInputPath = argv[++i];
+			options.convertOutputPath = argv[++i];
+		}
+		else if (argument == "--output" && hasValue) options.outputPath = argv[++i];
+		else if (argument == "--async-shaders") options.asyncShaders = true;
+		else if (argument == "--no-shader-cache") options.shaderCache = false;
+		else if (argument == "--no-font-cache") options.fontCache = false;
+		else if (argument == "--no-culling") options.frustumCulling = false;
+		else if (argument == "--trace" && hasValue) options.tracePath = argv[++i];
+		else if (argument == "--imgui-streaming") options.imguiStreaming = true;
+		else if (argument == "--no-mdi") options.multiDrawIndirect = false;
+		else if (argument == "--record" && hasValue) options.recordPath = argv[++i];
+		else if (argument == "--replay" && hasValue) options.replayPath = argv[++i];
+		else if (argument == "--frame-times" && hasValue) options.frameTimesPath = argv[++i];
+		else if (argument == "--capture" && hasValue) options.captureDirectory = argv[++i];
+		else if (argument == "--capture-format" && hasValue && FrameCapture::ParseFormat(argv[i + 1], options.captureFormat)) i++;
+		else if (argument == "--vertex-format" && hasValue && ParseVertexFormat(argv[i + 1], options.meshVertexFormat)) i++;
+		else
+		{
+			std::cout << "Unknown argument: " << argument << std::endl;
+			std::cout << "Usage: MatricesVisualizer [--headless] [--no-vsync] [--frames N] [--seconds T]"
+				" [--width W] [--height H] [--instances N] [--transform-bench N] [--mesh file.mvmesh|file.obj|file.ply]"
+				" [--convert input.obj|input.ply output.mvmesh] [--output report.json]"
+				" [--async-shaders] [--no-shader-cache] [--no-font-cache] [--no-culling] [--trace trace.json] [--imgui-streaming]"
+				" [--vertex-format float|half|snorm16] [--no-mdi] [--record input.mvinput] [--replay input.mvinput]"
+				" [--frame-times frames.csv] [--capture directory] [--capture-format png|raw]" << std::endl;
+			return false;
+		}
+	}
+
+	if (width <= 0 || height <= 0) {
+		logString("Width and height must be positive");
+		return false;
+	}
+
+	if (!options.shaderCache) ShaderProgram::SetBinaryCacheDirectory("");
+
+	return true;
+}
+
+// .mvmesh files are uploaded from their mapping, anything else goes through the OBJ/PLY importer
+static bool isBinaryMeshPath(const std::string& path)
+{
+	const std::string extension = ".mvmesh";
+	return path.size() >= extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+// Loads --mesh into the scene and shows it in place of the cube.
+// With an import job OBJ/PLY files are only started here and picked up by the render loop once parsed.
+static bool loadLaunchMesh(const LaunchOptions& options, Scene& scene, SceneControls& controls, MeshImportJob* importJob = nullptr)
+{
+	scene.setMeshVertexFormat(options.meshVertexFormat);
+	if (options.meshPath.empty()) return true;
+
+	if (!isBinaryMeshPath(options.meshPath) && importJob) return importJob->Start(options.meshPath);
+
+	auto loadStart = std::chrono::steady_clock::now();
+	std::string error;
+	if (isBinaryMeshPath(options.meshPath)) {
+		if (!scene.LoadMesh(options.meshPath, error)) {
+			logString(error.c_str());
+			return false;
+		}
+	}
+	else {
+		ThreadPool pool;
+		MeshData mesh;
+		if (!ImportMeshFile(options.meshPath, mesh, error, &pool)) {
+			logString(error.c_str());
+			return false;
+		}
+		scene.LoadMeshData(mesh);
+	}
+	double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+	std::cout << "Loaded " << options.meshPath << ": " << scene.getLoadedMeshVertexCount() << " vertices, "
+		<< scene.getLoadedMeshTriangleCount() << " triangles in " << loadMs << " ms" << std::endl;
+	controls.showLoadedMesh = true;
+
+	return true;
+}
+
+// Status line of the last background import, shown in the controls window
+static std::string meshImportStatus = "";
+
+// Uploads a finished background import, called from the render loop
+static void finishMeshImport(MeshImportJob& importJob, Scene& scene, SceneControls& controls)
+{
+	MeshData mesh;
+	std::string error;
+	if (!importJob.TakeResult(mesh, error)) {
+		meshImportStatus = "Import failed: " + error;
+		logString(meshImportStatus.c_str());
+		return;
+	}
+
+	scene.LoadMeshData(mesh);
+	controls.showLoadedMesh = true;
+
+	std::ostringstream status;
+	status << "Imported " << importJob.getFilePath() << ": " << mesh.getVertexCount() << " vertices, "
+		<< mesh.getTriangleCount() << " triangles in " << importJob.getImportMs() << " ms";
+	meshImportStatus = status.str();
+	logString(meshImportStatus.c_str());
+}
+
+// Offline OBJ/PLY -> .mvmesh conversion
+static int runConvert(const LaunchOptions& options)
+{
+	auto importStart = std::chrono::steady_clock::now();
+	ThreadPool pool;
+	MeshData mesh;
+	std::string error;
+	if (!ImportMeshFile(options.convertInputPath, mesh, error, &pool)) {
+		logString(error.c_str());
 		return -1;
 	}
-	
-	// Set OpenGL minumum version
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	double importMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - importStart).count();
 
-	window = glfwCreateWindow(width, height, "Matrices Visualizer", NULL, NULL);
+	if (!MeshFile::Write(options.convertOutputPath, mesh, error)) {
+		logString(error.c_str());
+		return -1;
+	}
 
-	if (!window) {
-		glfwTerminate();
-		logString("Window could not initialize");
+	std::cout << "Converted " << options.convertInputPath << " (" << mesh.getVertexCount() << " vertices, "
+		<< mesh.getTriangleCount() << " triangles, parsed in " << importMs << " ms) to "
+		<< options.convertOutputPath << std::endl;
+
+	return 0;
+}
+
+// One line per frame of a --frame-times file. Replays of the same log give the same checksums and update
+// indices, so two builds can be diffed on the timings alone
+struct FrameTiming
+{
+	double frameMs;
+	uint32_t modelViewProjectionChecksum;
+	unsigned int instanceUpdateIndex;
+};
+
+static FrameTiming makeFrameTiming(const Scene& scene, double frameMs)
+{
+	FrameTiming timing;
+	timing.frameMs = frameMs;
+	timing.modelViewProjectionChecksum = MatrixChecksum(scene.getMatrixCache().getModelViewProjection());
+	timing.instanceUpdateIndex = scene.getUploadedUpdateIndex();
+	return timing;
+}
+
+static bool writeFrameTimes(const std::string& filePath, const std::vector<FrameTiming>& timings)
+{
+	std::ofstream file(filePath);
+	if (!file) {
+		logString(("Could not open " + filePath).c_str());
+		return false;
+	}
+
+	file << "frame,ms,mvp_checksum,instance_update\n";
+	file.precision(4);
+	file << std::fixed;
+	for (size_t frame = 0; frame < timings.size(); frame++)
+	{
+		const FrameTiming& timing = timings[frame];
+		file << frame << "," << timing.frameMs << "," << std::hex << timing.modelViewProjectionChecksum << std::dec
+			<< "," << timing.instanceUpdateIndex << "\n";
+	}
+	return (bool)file;
+}
+
+static bool startInputRecording(const LaunchOptions& options, InputRecorder& recorder)
+{
+	if (options.recordPath.empty()) return true;
+
+	std::string error;
+	if (!recorder.Start(options.recordPath, error)) {
+		logString(error.c_str());
+		return false;
+	}
+	return true;
+}
+
+static bool stopInputRecording(InputRecorder& recorder)
+{
+	if (!recorder.isRecording()) return true;
+
+	unsigned int frameCount = recorder.getFrameCount();
+	std::string error;
+	if (!recorder.Stop(error)) {
+		logString(error.c_str());
+		return false;
+	}
+	std::cout << "Recorded " << frameCount << " frames, " << recorder.getByteCount() << " bytes" << std::endl;
+	return true;
+}
+
+// Builds the ImGui font atlas before the first frame asks for it, from font_cache/ unless turned off
+static bool buildImGuiFonts(const LaunchOptions& options)
+{
+	FontAtlasBuildInfo info;
+	if (!BuildFontAtlas(*ImGui::GetIO().Fonts, options.fontCache ? "font_cache" : "", info)) {
+		logString("Could not build the font atlas");
+		return false;
+	}
+
+	std::cout << "Font atlas " << info.width << "x" << info.height << " Alpha8 (" << info.width * info.height / 1024
+		<< " KB, " << info.glyphCount << " glyphs) " << (info.loadedFromCache ? "loaded from " + info.cachePath : "rasterized")
+		<< " in " << info.buildMs << " ms" << std::endl;
+	return true;
+}
+
+static void reportCapture(FrameCapture& capture)
+{
+	capture.Finish();
+	std::cout << "Captured " << capture.getCapturedCount() << " frames to " << capture.getDirectory() << ": written "
+		<< capture.GetWrittenCount() << ", dropped " << capture.getDroppedCount() << ", failed " << capture.GetFailedCount() << std::endl;
+}
+
+// Renders the scene into an offscreen framebuffer as fast as possible and reports frame times as JSON
+static int runHeadless(const LaunchOptions& options)
+{
+	HeadlessContext context(width, height);
+	if (!context.isValid()) {
+		logString(context.getError().c_str());
 		return -1;
 	}
+	auto startupStart = std::chrono::steady_clock::now();
 
-	glfwMakeContextCurrent(window);
-	glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
-	glfwSwapInterval(1); // vsync
 	glEnable(GL_DEPTH_TEST);
 
-	// ImGui
-	ImGui::CreateContext();
-	ImGui_ImplGlfwGL3_Init(window, true);
+	std::unique_ptr<ShaderCompileQueue> compileQueue;
+	if (options.asyncShaders && context.CreateSharedContext())
+	{
+		compileQueue.reset(new ShaderCompileQueue(
+			[&context]() { return context.MakeSharedContextCurrent(); },
+			[&context]() { context.ReleaseSharedContext(); }));
+		if (!compileQueue->isValid()) compileQueue.reset();
+	}
+	if (options.asyncShaders && !compileQueue) logString("No shared context, shaders are built on the render thread");
 
-	ImGui::StyleColorsDark();
-	ImVec2 windowSize = { 500, 600 };
+	// Instance updates run on these workers while frames are submitted
+	ThreadPool jobs;
+	Scene scene(jobs, compileQueue.get());
+	SceneControls controls;
+	controls.setOrthoFromSize(width, height);
+	controls.frustumCulling = options.frustumCulling;
+	controls.multiDrawIndirect = options.multiDrawIndirect;
+	if (!loadLaunchMesh(options, scene, controls)) return -1;
+	// Something worth rasterizing: both shapes, spinning, seen through the perspective projection
+	controls.showPrism = true;
+	controls.useProjectionMatrix = true;
+	controls.showOrthoProjection = false;
+	controls.useViewMatrix = true;
+	controls.viewEye = glm::vec3(0.0f, 0.0f, 3.0f);
+	if (options.instances > 0)
+	{
+		controls.useInstancing = true;
+		controls.instanceCount = options.instances;
+		controls.animateInstances = true;
+	}
 
-	// Add GLEW for OpenGL access
-	glewExperimental = GL_TRUE;
+	// A replay drives the controls frame by frame instead of the built-in rotation
+	InputReplay replay;
+	if (!options.replayPath.empty())
+	{
+		std::string error;
+		if (!replay.Load(options.replayPath, error)) {
+			logString(error.c_str());
+			return -1;
+		}
+	}
+	bool replaying = replay.getFrameCount() > 0;
 
-	GLenum glewInitialize = glewInit();
-	if (glewInitialize != GLEW_OK) {
-		std::cout << "Error glewInit: " << glewGetErrorString(glewInitialize);
-		glfwTerminate();
-		return -1;
+	InputRecorder recorder;
+	if (!startInputRecording(options, recorder)) return -1;
+	// Recorded and replayed runs must not depend on how fast the workers happen to be
+	scene.setLockstepUpdates(replaying || recorder.isRecording());
+
+	int frameLimit = options.frames;
+	if (frameLimit <= 0 && options.seconds <= 0.0) frameLimit = 600;
+	if (replaying && (frameLimit <= 0 || frameLimit > (int)replay.getFrameCount())) frameLimit = (int)replay.getFrameCount();
+
+	// Only when a trace is asked for, the zones and queries are not free
+	std::unique_ptr<Profiler> profiler;
+	if (!options.tracePath.empty()) profiler.reset(new Profiler());
+	scene.setProfiler(profiler.get());
+
+	std::unique_ptr<FrameCapture> capture;
+	if (!options.captureDirectory.empty()) capture.reset(new FrameCapture(options.captureDirectory, options.captureFormat));
+
+	FrameStats stats;
+	std::vector<FrameTiming> frameTimings;
+	auto runStart = std::chrono::steady_clock::now();
+
+	for (int frame = 0; ; frame++)
+	{
+		if (frameLimit > 0 && frame >= frameLimit) break;
+		if (options.seconds > 0.0 &&
+			std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count() >= options.seconds) break;
+
+		auto frameStart = std::chrono::steady_clock::now();
+
+		float aspectRatio = (float)width / (float)height;
+		if (replaying)
+		{
+			controls = replay.getFrame(frame).controls;
+			aspectRatio = replay.getFrame(frame).aspectRatio;
+		}
+		else
+		{
+			controls.rotationXDegrees = std::fmod(frame * 0.5f, 360.0f);
+			controls.rotationYDegrees = std::fmod(frame * 1.0f, 360.0f);
+		}
+		recorder.RecordFrame(controls, aspectRatio);
+
+		if (profiler) profiler->BeginFrame();
+		context.BindFramebuffer();
+		{
+			ProfileZone zone(profiler.get(), "Scene draw");
+			GpuProfileZone gpuZone(profiler.get(), "Scene");
+			scene.Draw(controls, aspectRatio);
+		}
+		if (capture)
+		{
+			ProfileZone zone(profiler.get(), "Capture");
+			capture->Capture(width, height);
+		}
+		{
+			// Nothing is presented, wait for the GPU (or llvmpipe) so the frame is actually measured
+			ProfileZone zone(profiler.get(), "Finish");
+			glFinish();
+		}
+		if (profiler) profiler->EndFrame();
+
+		auto frameEnd = std::chrono::steady_clock::now();
+		double frameMs = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+		stats.AddFrame(frameMs);
+		if (!options.frameTimesPath.empty()) frameTimings.push_back(makeFrameTiming(scene, frameMs));
+		if (frame == 0) stats.setStartupMs(std::chrono::duration<double, std::milli>(frameEnd - startupStart).count());
+	}
+
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	std::string mode = replaying ? "headless-replay" : controls.useInstancing ? "headless-instanced" : "headless";
+	std::string report = stats.ToJson(mode, width, height, renderer ? renderer : "unknown");
+	std::cout << report;
+
+	if (!options.outputPath.empty())
+	{
+		std::ofstream outputFile(options.outputPath);
+		if (!outputFile) {
+			logString("Could not write benchmark report");
+			return -1;
+		}
+		outputFile << report;
 	}
 
-	// VAO, VBO
-	unsigned int VAO, VBO, EBO;
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
+	if (capture) reportCapture(*capture);
+	if (!options.frameTimesPath.empty() && !writeFrameTimes(options.frameTimesPath, frameTimings)) return -1;
+	if (!stopInputRecording(recorder)) return -1;
 
-	glBindVertexArray(VAO);
+	if (profiler)
+	{
+		// One more frame so the GPU times of the last ones are picked up
+		profiler->BeginFrame();
+		profiler->DiscardFrame();
+		std::string error;
+		if (!profiler->WriteChromeTrace(options.tracePath, error)) {
+			logString(error.c_str());
+			return -1;
+		}
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), &vertices, GL_STATIC_DRAW);
-	// vertex position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	// vertex color
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
+	return 0;
+}
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), &indices, GL_STATIC_DRAW);
+// Times every transform kernel on the same random batch and checks the SIMD ones against the glm reference
+static int runTransformBenchmark(const LaunchOptions& options)
+{
+	const int iterations = 20;
+	const double tolerance = 1e-4;
+	size_t count = (size_t)options.transformBenchmarkCount;
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	
-	// Prism
-	unsigned int VAO2, VBO2, EBO2;
-	glGenVertexArrays(1, &VAO2);
-	glGenBuffers(1, &VBO2);
-	glGenBuffers(1, &EBO2);
-
-	glBindVertexArray(VAO2);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO2);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(prismVertices), &prismVertices, GL_STATIC_DRAW);
-	// vertex position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-	// vertex color
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-	glEnableVertexAttribArray(1);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO2);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(prismIndices), &prismIndices, GL_STATIC_DRAW);
-
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
-
-	ShaderProgram shaderProgram = ShaderProgram(
-		"resources/vertex.shader",
-		"resources/fragment.shader"
-	);
-
-	// ---- Objects
-	bool showPrism = false;
-
-	// ---- MVP
-	// Model
-	glm::vec3 translateVector = glm::vec3(0.0f, 0.0f, 0.0f);
-	float rotationXDegrees = 0.0f;
-	glm::vec3 rotationXAxis = glm::vec3(1.0f, 0.0f, 0.0f);
-	float rotationYDegrees = 0.0f;
-	glm::vec3 rotationYAxis = glm::vec3(0.0f, 1.0f, 0.0f);
-	float rotationZDegrees = 0.0f;
-	glm::vec3 rotationZAxis = glm::vec3(0.0f, 0.0f, 1.0f);
-	// View
-	glm::vec3 viewEye = glm::vec3(0.0f, 0.0f, 1.1f);
-	glm::vec3 viewCenter = glm::vec3(0.0f, 0.0f, 0.0f);
-	glm::vec3 viewUpDown = glm::vec3(0.0f, 1.0f, 0.0f);
-	// Perspective
-	// Ortho
-	float aspectRatio = (float)width / (float)height;
-	float size = 4.0f;
-
-	float orthoLeft = -(float)width / 200.0f; // -aspectRatio * size / 2.0f;
-	float orthoRight = (float)width / 200.0f; // aspectRatio * size / 2.0f;
-	float orthoBottom = -(float)height / 200.0f; // -size / 2.0f;
-	float orthoTop = (float)height / 200.0f; // size / 2.0f;
-	// Perspective
-	float fov = 45.0f;
-	
-	// Checkbox for choosing projection
-	bool showOrthoProjection = true;
-	bool useViewMatrix = false;
-	bool useProjectionMatrix = false;
+	TransformBatch batch;
+	std::srand(1234);
+	auto random = [](float low, float high) { return low + (high - low) * ((float)std::rand() / (float)RAND_MAX); };
+	for (size_t i = 0; i < count; i++)
+	{
+		batch.Add(
+			glm::vec3(random(-5.0f, 5.0f), random(-5.0f, 5.0f), random(-5.0f, 5.0f)),
+			glm::vec3(random(0.0f, 360.0f), random(0.0f, 360.0f), random(0.0f, 360.0f)),
+			glm::vec3(random(0.1f, 2.0f), random(0.1f, 2.0f), random(0.1f, 2.0f))
+		);
+	}
 
-	// TODO: add color to vertices
-	// TODO: add texture
+	glm::mat4 viewProjection = glm::perspective(glm::radians(45.0f), (float)width / (float)height, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 
-	unsigned int mvpLocation = glGetUniformLocation(shaderProgram.getProgramId(), "modelViewProjection");
+	std::vector<glm::mat4> reference(count);
+	std::vector<glm::mat4> output(count);
+	batch.ComputeModelViewProjections(viewProjection, reference.data(), TransformKernel::Scalar);
 
-	while (!glfwWindowShouldClose(window))
+	bool allMatch = true;
+	std::ostringstream json;
+	json << "{\n  \"transforms\": " << count << ",\n  \"kernels\": [\n";
+
+	TransformKernel kernels[3] = { TransformKernel::Scalar, TransformKernel::Sse, TransformKernel::Avx2 };
+	for (int k = 0; k < 3; k++)
+	{
+		// Kernels the CPU lacks fall back to narrower ones, do not report them twice
+		if (kernels[k] == TransformKernel::Avx2 && TransformBatch::GetBestKernel() != TransformKernel::Avx2) continue;
+		if (kernels[k] == TransformKernel::Sse && TransformBatch::GetBestKernel() == TransformKernel::Scalar) continue;
+
+		FrameStats stats;
+		for (int i = 0; i < iterations; i++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			batch.ComputeModelViewProjections(viewProjection, output.data(), kernels[k]);
+			stats.AddFrame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+		}
+
+		double maxError = 0.0;
+		for (size_t i = 0; i < count; i++)
+			for (int column = 0; column < 4; column++)
+				for (int row = 0; row < 4; row++)
+					maxError = std::max(maxError, (double)std::fabs(output[i][column][row] - reference[i][column][row]));
+		allMatch = allMatch && maxError <= tolerance;
+
+		json << (k > 0 ? ",\n" : "") << "    { \"kernel\": \"" << TransformBatch::GetKernelName(kernels[k])
+			<< "\", \"minMs\": " << stats.GetMinMs() << ", \"avgMs\": " << stats.GetAverageMs()
+			<< ", \"maxError\": " << maxError << " }";
+	}
+	json << "\n  ],\n  \"match\": " << (allMatch ? "true" : "false") << "\n}\n";
+
+	std::cout << json.str();
+
+	return allMatch ? 0 : 1;
+}
+
+// Returns true when any control was changed this frame
+static bool buildControlsWindow(SceneControls& controls, const ImVec2& windowSize, const Scene& scene, MeshImportJob& importJob)
+{
+	bool changed = false;
+
+	// Dear Im GUI
+	ImGui::SetNextWindowSize(windowSize);
+	bool imGuiwindow = ImGui::Begin("Im GUI Hello");
+	if (imGuiwindow)
 	{
-		glfwPollEvents();
-
-		glBindVertexArray(VAO);
-		glClearColor(0.1f, 0.1f, 0.0f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		ImGui_ImplGlfwGL3_NewFrame();
-
-		// Send MVP to shader with uniform
-		glm::mat4 modelMatrix = glm::mat4(1.0f);
-		glm::mat4 rotationMatrix = glm::mat4(1.0f);
-		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(rotationXDegrees), rotationXAxis);
-		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(rotationYDegrees), rotationYAxis);
-		rotationMatrix = glm::rotate(rotationMatrix, glm::radians(rotationZDegrees), rotationZAxis);
-		glm::mat4 translateMatrix = glm::translate(glm::mat4(1.0f), translateVector);
-		modelMatrix = translateMatrix * rotationMatrix;
-		glm::mat4 viewMatrix = glm::mat4(1.0f);
-		glm::mat4 modelViewProjection;
-
-		if (useViewMatrix)
+		// Model Matrix
+		ImGui::Text("Model Matrix");
+		// Rotation
+		changed |= ImGui::SliderFloat("Model Rotation X", &controls.rotationXDegrees, 0.0f, 360.0f);
+		changed |= ImGui::SliderFloat("Model Rotation Y", &controls.rotationYDegrees, 0.0f, 360.0f);
+		changed |= ImGui::SliderFloat("Model Rotation Z", &controls.rotationZDegrees, 0.0f, 360.0f);
+		// Translation
+		changed |= ImGui::SliderFloat("Model Translate X", &controls.translateVector.x, -1.0f, 1.0f, "%.1f", 1.0f);
+		changed |= ImGui::SliderFloat("Model Translate Y", &controls.translateVector.y, -1.0f, 1.0f, "%.1f", 1.0f);
+		changed |= ImGui::SliderFloat("Model Translate Z", &controls.translateVector.z, -1.0f, 1.0f, "%.1f", 1.0f);
+
+		// View matrix
+		ImGui::Text("View Matrix");
+		changed |= ImGui::Checkbox("Use View Matrix", &controls.useViewMatrix);
+		if (controls.useViewMatrix)
 		{
-			viewMatrix = glm::lookAt(
-				viewEye, // eye
-				viewCenter, // center
-				viewUpDown // up/down - use y only?
-			);
+			// Eye
+			changed |= ImGui::SliderFloat("View Eye X", &controls.viewEye.x, -5.0f, 5.0f, "%.1f", 1.0f);
+			changed |= ImGui::SliderFloat("View Eye Y", &controls.viewEye.y, -5.0f, 5.0f, "%.1f", 1.0f);
+			changed |= ImGui::SliderFloat("View Eye Z", &controls.viewEye.z, -5.0f, 5.0f, "%.1f", 1.0f);
+
+			// Center
+			changed |= ImGui::SliderFloat("View Center X", &controls.viewCenter.x, 0.0f, 5.0f, "%.1f", 1.0f);
+			changed |= ImGui::SliderFloat("View Center Y", &controls.viewCenter.y, 0.0f, 5.0f, "%.1f", 1.0f);
+			changed |= ImGui::SliderFloat("View Center Z", &controls.viewCenter.z, -1.0f, 1.0f, "%.1f", 1.0f);
 		}
 
-		if (useProjectionMatrix)
+		// Projection
+		ImGui::Text("Projection Matrix");
+		changed |= ImGui::Checkbox("Use Projection Matrix", &controls.useProjectionMatrix);
+		if (controls.useProjectionMatrix)
 		{
-			if (showOrthoProjection)
+			changed |= ImGui::Checkbox("Show Orthographic:", &controls.showOrthoProjection);
+			if (controls.showOrthoProjection)
 			{
-				glm::mat4 orthoProjection = glm::mat4(1.0f);
-				orthoProjection = glm::ortho(orthoLeft, orthoRight, orthoBottom, orthoTop, 0.1f, 100.0f);
-				if (useViewMatrix) modelViewProjection = orthoProjection * viewMatrix * modelMatrix;
-				else modelViewProjection = orthoProjection * modelMatrix;
+				// TODO: add sliders for ortho projection
+				ImGui::Text("Ortho Left %f", controls.orthoLeft);
+				ImGui::Text("Ortho Right %f", controls.orthoRight);
+				ImGui::Text("Ortho Bottom %f", controls.orthoBottom);
+				ImGui::Text("Ortho Top %f", controls.orthoTop);
 			}
 			else
 			{
-				glm::mat4 perspectiveProjection = glm::mat4(1.0f);
-				perspectiveProjection = glm::perspective(glm::radians(fov), (float)width / (float)height, 0.1f, 100.0f);
-				if (useViewMatrix) modelViewProjection = perspectiveProjection * viewMatrix * modelMatrix;
-				else modelViewProjection = perspectiveProjection * modelMatrix;
+				changed |= ImGui::SliderFloat("Field of View", &controls.fov, 0.0f, 100.0f, "%.1f", 1.0f);
 			}
-		} else modelViewProjection = modelMatrix;
+		}
 
-		glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &modelViewProjection[0][0]);
+		// Prism
+		changed |= ImGui::Checkbox("Show Prism", &controls.showPrism);
 
-		glDrawElements(GL_TRIANGLES, sizeof(indices), GL_UNSIGNED_INT, (void*)0);
+		// Loaded mesh
+		if (scene.hasLoadedMesh())
+		{
+			changed |= ImGui::Checkbox("Show Loaded Mesh", &controls.showLoadedMesh);
+			ImGui::Text("%u vertices, %u triangles", scene.getLoadedMeshVertexCount(), scene.getLoadedMeshTriangleCount());
+			ImGui::Text("%s vertices %.1f KB, %d-bit indices %.1f KB", GetVertexFormatName(scene.getLoadedMeshVertexFormat()),
+				scene.getLoadedMeshVertexBytes() / 1024.0, scene.hasShortMeshIndices() ? 16 : 32, scene.getLoadedMeshIndexBytes() / 1024.0);
+		}
 
-		if (showPrism)
+		// OBJ/PLY import, parsed on worker threads while this window keeps drawing
+		static char importPath[512] = "";
+		ImGui::InputText("Mesh File", importPath, sizeof(importPath));
+		if (importJob.isRunning())
+			ImGui::ProgressBar(importJob.GetProgress());
+		else if (ImGui::Button("Import OBJ/PLY") && importPath[0] != '\0')
+			importJob.Start(importPath);
+		if (!meshImportStatus.empty())
+			ImGui::TextWrapped("%s", meshImportStatus.c_str());
+
+		// Culling, the counts show what the projection keeps in view
+		changed |= ImGui::Checkbox("Frustum Culling", &controls.frustumCulling);
+		ImGui::Text("Objects drawn %d, culled %d", scene.getDrawnObjectCount(), scene.getCulledObjectCount());
+
+		// Geometry pool, one submission per frame with multi-draw indirect
+		const GeometryPool& geometry = scene.getGeometryPool();
+		if (geometry.hasMultiDrawIndirect())
+			changed |= ImGui::Checkbox("Multi-Draw Indirect", &controls.multiDrawIndirect);
+		else ImGui::Text("Multi-draw indirect unavailable, drawing in a loop");
+		ImGui::Text("Pool: %u meshes, %u vertices, %u indices, %u draw calls", geometry.getMeshCount(),
+			geometry.getVertexCapacity(), geometry.getIndexCapacity(), geometry.getSubmissionCount());
+		if (geometry.isUsingMultiDrawIndirect())
+			ImGui::Text("Command stream: %.1f KB streamed, %u stalls", geometry.getIndirectStream().getBytesStreamed() / 1024.0,
+				geometry.getIndirectStream().getStallCount());
+
+		// Instancing
+		changed |= ImGui::Checkbox("Instanced Grid", &controls.useInstancing);
+		if (controls.useInstancing)
 		{
-			glBindVertexArray(VAO2);
-			glDrawElements(GL_TRIANGLES, sizeof(prismIndices), GL_UNSIGNED_INT, (void*)0);
+			changed |= ImGui::SliderInt("Instance Count", &controls.instanceCount, 1, Scene::maxInstanceCount);
+			changed |= ImGui::Checkbox("Animate Instances", &controls.animateInstances);
+			ImGui::Text("Transform kernel: %s", TransformBatch::GetKernelName(TransformKernel::Auto));
+			if (!scene.isInstancedShaderReady()) ImGui::Text("Instanced shader is still building");
+			else if (!scene.getInstancedShaderProgram().isLinked()) ImGui::Text("Instanced shader failed to build, drawing the single cube");
+			const SceneUpdate& sceneUpdate = scene.getSceneUpdate();
+			ImGui::Text("Update: %u objects in %u chunks, %.3f ms", (unsigned int)sceneUpdate.getObjectCount(),
+				(unsigned int)sceneUpdate.getChunkCount(), sceneUpdate.getLastUpdateMs());
+			ImGui::Text("Snapshots published %u, jobs stolen %u", sceneUpdate.getPublishedCount(), sceneUpdate.getStealCount());
+			const StreamBuffer& instanceStream = scene.getInstanceStream();
+			ImGui::Text("Instance stream: %s, %.1f MB streamed, %u stalls", instanceStream.isPersistent() ? "persistent" : "orphaned",
+				instanceStream.getBytesStreamed() / (1024.0 * 1024.0), instanceStream.getStallCount());
 		}
 
-		// Dear Im GUI
-		ImGui::SetNextWindowSize(windowSize);
-		bool imGuiwindow = ImGui::Begin("Im GUI Hello");
-		if (imGuiwindow)
+		// Render loop
+		ImGui::Text("Render Loop");
+		ImGui::Checkbox("Idle When Unchanged", &renderLoop.idleWhenUnchanged);
+		// Compare the "ImGui render" zones in the profiler with it on and off
+		bool streamingUpload = ImGui_ImplGlfwGL3_GetRenderMode() == ImGui_ImplGlfwGL3_RenderMode_Streaming;
+		if (ImGui::Checkbox("Streaming ImGui Upload", &streamingUpload))
+			ImGui_ImplGlfwGL3_SetRenderMode(streamingUpload ? ImGui_ImplGlfwGL3_RenderMode_Streaming : ImGui_ImplGlfwGL3_RenderMode_Default);
+		ImGui::Text("Frames rendered %u, idle wakeups skipped %u", renderLoop.renderedFrames, renderLoop.skippedFrames);
+		const MatrixCache& matrixCache = scene.getMatrixCache();
+		ImGui::Text("Matrix updates: model %u, view %u, projection %u",
+			matrixCache.getModelUpdateCount(), matrixCache.getViewUpdateCount(), matrixCache.getProjectionUpdateCount());
+		ImGui::Text("Camera buffer uploads %u", scene.getCameraUniforms().getUploadCount());
+
+		ImGui::End();
+	}
+
+	return changed;
+}
+
+// Starts and stops the image sequence capture, the directory and format come from the command line or their defaults
+static void buildCaptureWindow(std::unique_ptr<FrameCapture>& capture, const LaunchOptions& options)
+{
+	ImGui::SetNextWindowPos(ImVec2((float)width - 420.0f, 370.0f), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(420.0f, 110.0f), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Capture"))
+	{
+		ImGui::End();
+		return;
+	}
+
+	bool capturing = capture != nullptr;
+	if (ImGui::Checkbox("Capture Frames", &capturing))
+	{
+		// Stopping waits for the frames still being read back or written
+		if (capture) reportCapture(*capture);
+		if (capturing)
 		{
-			// Model Matrix
-			ImGui::Text("Model Matrix");
-			// Rotation
-			ImGui::SliderFloat("Model Rotation X", &rotationXDegrees, 0.0f, 360.0f);
-			ImGui::SliderFloat("Model Rotation Y", &rotationYDegrees, 0.0f, 360.0f);
-			ImGui::SliderFloat("Model Rotation Z", &rotationZDegrees, 0.0f, 360.0f);
-			// Translation
-			ImGui::SliderFloat("Model Translate X", &translateVector.x, -1.0f, 1.0f, "%.1f", 1.0f);
-			ImGui::SliderFloat("Model Translate Y", &translateVector.y, -1.0f, 1.0f, "%.1f", 1.0f);
-			ImGui::SliderFloat("Model Translate Z", &translateVector.z, -1.0f, 1.0f, "%.1f", 1.0f);
-
-			// View matrix
-			ImGui::Text("View Matrix");
-			ImGui::Checkbox("Use View Matrix", &useViewMatrix);
-			if (useViewMatrix)
-			{
-				// Eye
-				ImGui::SliderFloat("View Eye X", &viewEye.x, -5.0f, 5.0f, "%.1f", 1.0f);
-				ImGui::SliderFloat("View Eye Y", &viewEye.y, -5.0f, 5.0f, "%.1f", 1.0f);
-				ImGui::SliderFloat("View Eye Z", &viewEye.z, -5.0f, 5.0f, "%.1f", 1.0f);
-
-				// Center
-				ImGui::SliderFloat("View Center X", &viewCenter.x, 0.0f, 5.0f, "%.1f", 1.0f);
-				ImGui::SliderFloat("View Center Y", &viewCenter.y, 0.0f, 5.0f, "%.1f", 1.0f);
-				ImGui::SliderFloat("View Center Z", &viewCenter.z, -1.0f, 1.0f, "%.1f", 1.0f);
-			}
+			std::string directory = options.captureDirectory.empty() ? "capture" : options.captureDirectory;
+			capture.reset(new FrameCapture(directory, options.captureFormat));
+		}
+		else capture.reset();
+	}
 
-			// Projection
-			ImGui::Text("Projection Matrix");
-			ImGui::Checkbox("Use Projection Matrix", &useProjectionMatrix);
-			if (useProjectionMatrix)
-			{
-				ImGui::Checkbox("Show Orthographic:", &showOrthoProjection);
-				if (showOrthoProjection)
-				{
-					// TODO: add sliders for ortho projection
-					ImGui::Text("Ortho Left %f", orthoLeft);
-					ImGui::Text("Ortho Right %f", orthoRight);
-					ImGui::Text("Ortho Bottom %f", orthoBottom);
-					ImGui::Text("Ortho Top %f", orthoTop);
-				}
-				else
-				{
-					ImGui::SliderFloat("Field of View", &fov, 0.0f, 100.0f, "%.1f", 1.0f);
-				}
-			}
+	if (capture)
+	{
+		ImGui::Text("%s files in %s", FrameCapture::GetFormatName(capture->getFormat()), capture->getDirectory().c_str());
+		ImGui::Text("Captured %u, written %u, in flight %u", capture->getCapturedCount(), capture->GetWrittenCount(),
+			capture->GetQueuedCount());
+		ImGui::Text("Dropped %u, failed %u", capture->getDroppedCount(), capture->GetFailedCount());
+	}
+
+	ImGui::End();
+}
+
+// Frame time graph and zone averages over the profiler history
+static void buildProfilerWindow(const Profiler& profiler, const std::string& tracePath)
+{
+	static std::string exportStatus = "";
 
-			// Prism
-			ImGui::Checkbox("Show Prism", &showPrism);
+	ImGui::SetNextWindowPos(ImVec2((float)width - 420.0f, 0.0f), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowSize(ImVec2(420.0f, 360.0f), ImGuiCond_FirstUseEver);
+	if (!ImGui::Begin("Profiler"))
+	{
+		ImGui::End();
+		return;
+	}
 
-			ImGui::End();
+	const std::deque<ProfileFrame>& frames = profiler.getFrames();
+	std::vector<float> cpuMs, gpuMs;
+	double cpuTotal = 0.0, gpuTotal = 0.0;
+	int gpuFrames = 0;
+	// Average per frame of every zone, in first seen order
+	std::vector<std::pair<std::string, double>> zoneTotals;
+	for (const ProfileFrame& frame : frames)
+	{
+		cpuMs.push_back((float)frame.cpuMs);
+		gpuMs.push_back(frame.gpuReady ? (float)frame.gpuMs : 0.0f);
+		cpuTotal += frame.cpuMs;
+		if (frame.gpuReady)
+		{
+			gpuTotal += frame.gpuMs;
+			gpuFrames++;
 		}
 
-		ImGui::Render();
-		ImGui_ImplGlfwGL3_RenderDrawData(ImGui::GetDrawData());
+		for (const ProfileZoneTiming& zone : frame.cpuZones)
+		{
+			auto total = std::find_if(zoneTotals.begin(), zoneTotals.end(),
+				[&zone](const std::pair<std::string, double>& entry) { return entry.first == zone.name; });
+			if (total == zoneTotals.end()) zoneTotals.emplace_back(zone.name, zone.durationMs);
+			else total->second += zone.durationMs;
+		}
+	}
+
+	if (!frames.empty())
+	{
+		ImVec2 graphSize = ImVec2(0.0f, 60.0f);
+		ImGui::PlotLines("CPU ms", cpuMs.data(), (int)cpuMs.size(), 0, NULL, 0.0f, FLT_MAX, graphSize);
+		ImGui::PlotLines("GPU ms", gpuMs.data(), (int)gpuMs.size(), 0, NULL, 0.0f, FLT_MAX, graphSize);
+		ImGui::Text("Average over %d frames: CPU %.3f ms, GPU %.3f ms", (int)frames.size(),
+			cpuTotal / (double)frames.size(), gpuFrames > 0 ? gpuTotal / (double)gpuFrames : 0.0);
+	}
+	if (!profiler.hasGpuTimers()) ImGui::Text("GPU timer queries are not available");
+	else ImGui::Text("GPU results dropped for %u frames", profiler.getDroppedGpuFrameCount());
+
+	ImGui::Separator();
+	for (const std::pair<std::string, double>& total : zoneTotals)
+		ImGui::Text("%-14s %8.3f ms", total.first.c_str(), total.second / (double)frames.size());
+
+	ImGui::Separator();
+	if (ImGui::Button("Export Chrome Trace"))
+	{
+		std::string error;
+		exportStatus = profiler.WriteChromeTrace(tracePath, error) ? "Wrote " + tracePath : error;
+	}
+	if (!exportStatus.empty()) ImGui::TextWrapped("%s", exportStatus.c_str());
+
+	ImGui::End();
+}
+
+// The interactive window loop. Every local here owns GL objects (or zones and queries of them), so they are all
+// destroyed when it returns, while the context is still current and before the compile queue goes away
+static int runWindowed(const LaunchOptions& options, GLFWwindow* window, ShaderCompileQueue* compileQueue)
+{
+	ImVec2 windowSize = { 500, 600 };
+
+	// Cube and prism VAO, VBO, EBO + shader program, instance updates run on the job workers
+	ThreadPool jobs;
+	Scene scene(jobs, compileQueue);
+
+	SceneControls controls;
+	controls.setOrthoFromSize(width, height);
+	controls.frustumCulling = options.frustumCulling;
+	controls.multiDrawIndirect = options.multiDrawIndirect;
+	MeshImportJob importJob;
+	if (!loadLaunchMesh(options, scene, controls, &importJob)) {
+		return -1;
+	}
+
+	// CPU zones and GPU timer queries for the profiler window
+	Profiler profiler;
+	scene.setProfiler(&profiler);
+	std::string tracePath = options.tracePath.empty() ? "profile_trace.json" : options.tracePath;
+
+	// Replays take over the controls until the log ends, the window stays interactive afterwards
+	InputReplay replay;
+	if (!options.replayPath.empty())
+	{
+		std::string error;
+		if (!replay.Load(options.replayPath, error)) {
+			logString(error.c_str());
+			return -1;
+		}
+	}
+	size_t replayFrame = 0;
+	FrameStats replayStats;
+	std::vector<FrameTiming> replayTimings;
+
+	InputRecorder recorder;
+	if (!startInputRecording(options, recorder)) {
+		return -1;
+	}
+	if (recorder.isRecording()) inputRecorder = &recorder;
+	scene.setLockstepUpdates(replay.getFrameCount() > 0 || recorder.isRecording());
+
+	// Reads the scene back without the UI, drawn after it
+	std::unique_ptr<FrameCapture> capture;
+	if (!options.captureDirectory.empty()) capture.reset(new FrameCapture(options.captureDirectory, options.captureFormat));
+
+	// TODO: add color to vertices
+	// TODO: add texture
+
+	while (!glfwWindowShouldClose(window))
+	{
+		// A finished import is uploaded by the frame below, the loop must not sleep on it
+		bool importFinished = importJob.isFinished();
+		// A running import or shader build only needs the window refreshed now and then
+		bool backgroundWork = importJob.isRunning() || (controls.useInstancing && !scene.isInstancedShaderReady());
+		bool animatingInstances = controls.useInstancing && controls.animateInstances;
+		bool replaying = replayFrame < replay.getFrameCount();
+		bool animating = animatingInstances || backgroundWork || replaying;
+		bool idle = renderLoop.idleWhenUnchanged && !animating && !importFinished &&
+			!renderLoop.inputEventPending && renderLoop.framesToRender == 0;
+		bool progressOnly = renderLoop.idleWhenUnchanged && backgroundWork && !animatingInstances && !importFinished &&
+			!renderLoop.inputEventPending && renderLoop.framesToRender == 0;
+
+		// Blocking for input happens before the frame starts, so idle time never counts as frame time
+		if (idle) glfwWaitEvents();
+		else if (progressOnly) glfwWaitEventsTimeout(1.0 / 30.0);
+
+		auto frameStart = std::chrono::steady_clock::now();
+		profiler.BeginFrame();
+
+		if (importFinished)
+		{
+			finishMeshImport(importJob, scene, controls);
+			renderLoop.framesToRender = framesAfterInput;
+		}
+
+		{
+			// After a wait this only picks up what arrived since it returned
+			ProfileZone zone(&profiler, "Event poll");
+			glfwPollEvents();
+		}
+
+		if (renderLoop.inputEventPending)
+		{
+			renderLoop.inputEventPending = false;
+			renderLoop.framesToRender = framesAfterInput;
+		}
+
+		// Woken up without anything to show (e.g. an empty event), keep the previous frame
+		if (renderLoop.idleWhenUnchanged && !animating && renderLoop.framesToRender == 0)
+		{
+			renderLoop.skippedFrames++;
+			profiler.DiscardFrame();
+			continue;
+		}
+
+		float aspectRatio = (float)width / (float)height;
+		if (replaying)
+		{
+			controls = replay.getFrame(replayFrame).controls;
+			aspectRatio = replay.getFrame(replayFrame).aspectRatio;
+		}
+		recorder.RecordFrame(controls, aspectRatio);
+
+		{
+			ProfileZone zone(&profiler, "Scene draw");
+			GpuProfileZone gpuZone(&profiler, "Scene");
+			scene.Draw(controls, aspectRatio);
+		}
+		if (capture)
+		{
+			ProfileZone zone(&profiler, "Capture");
+			capture->Capture(width, height);
+		}
+
+		{
+			ProfileZone zone(&profiler, "ImGui build");
+			ImGui_ImplGlfwGL3_NewFrame();
+			if (buildControlsWindow(controls, windowSize, scene, importJob))
+				renderLoop.framesToRender = framesAfterInput;
+			buildProfilerWindow(profiler, tracePath);
+			buildCaptureWindow(capture, options);
+		}
+		if (renderLoop.framesToRender > 0) renderLoop.framesToRender--;
+		renderLoop.renderedFrames++;
+
+		{
+			ProfileZone zone(&profiler, "ImGui render");
+			GpuProfileZone gpuZone(&profiler, "ImGui");
+			ImGui::Render();
+			ImGui_ImplGlfwGL3_RenderDrawData(ImGui::GetDrawData());
+		}
 
 		/*int display_w, display_h;
 		glfwGetFramebufferSize(window, &display_w, &display_h);
 		glViewport(0, 0, display_w, display_h);*/
 
-		glfwSwapBuffers(window);
+		{
+			ProfileZone zone(&profiler, "Swap");
+			glfwSwapBuffers(window);
+		}
+		profiler.EndFrame();
+
+		if (replaying)
+		{
+			double frameMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+			replayStats.AddFrame(frameMs);
+			replayTimings.push_back(makeFrameTiming(scene, frameMs));
+			if (++replayFrame == replay.getFrameCount())
+			{
+				std::cout << "Replayed " << replayFrame << " frames, average " << replayStats.GetAverageMs() << " ms, p99 "
+					<< replayStats.GetPercentileMs(99.0) << " ms" << std::endl;
+				if (!options.frameTimesPath.empty()) writeFrameTimes(options.frameTimesPath, replayTimings);
+				scene.setLockstepUpdates(recorder.isRecording());
+			}
+		}
+	}
+
+	inputRecorder = nullptr;
+	stopInputRecording(recorder);
+	if (capture)
+	{
+		reportCapture(*capture);
+		capture.reset();
+	}
+
+	if (!options.tracePath.empty())
+	{
+		std::string error;
+		if (!profiler.WriteChromeTrace(options.tracePath, error)) logString(error.c_str());
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	LaunchOptions options;
+	if (!parseLaunchOptions(argc, argv, options)) return -1;
+
+	if (options.transformBenchmarkCount > 0) return runTransformBenchmark(options);
+	if (!options.convertInputPath.empty()) return runConvert(options);
+	if (options.headless) return runHeadless(options);
+
+	// Create window
+	GLFWwindow* window;
+
+	if (!glfwInit()) {
+		logString("GLFW could not initialize");
+		return -1;
+	}
+	
+	// Set OpenGL minumum version
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+	window = glfwCreateWindow(width, height, "Matrices Visualizer", NULL, NULL);
+
+	if (!window) {
+		glfwTerminate();
+		logString("Window could not initialize");
+		return -1;
+	}
+
+	glfwMakeContextCurrent(window);
+	glfwSetFramebufferSizeCallback(window, frameBufferSizeCallback);
+	glfwSwapInterval(options.vsync ? 1 : 0); // vsync
+	glEnable(GL_DEPTH_TEST);
+
+	// ImGui, its input callbacks are chained from ours so any input wakes the idle loop
+	ImGui::CreateContext();
+	ImGui_ImplGlfwGL3_Init(window, false);
+	// The loop keeps the state the streaming mode expects: depth test on, blending and scissoring off
+	if (options.imguiStreaming) ImGui_ImplGlfwGL3_SetRenderMode(ImGui_ImplGlfwGL3_RenderMode_Streaming);
+	glfwSetMouseButtonCallback(window, mouseButtonCallback);
+	glfwSetScrollCallback(window, scrollCallback);
+	glfwSetKeyCallback(window, keyCallback);
+	glfwSetCharCallback(window, charCallback);
+	glfwSetCursorPosCallback(window, cursorPosCallback);
+	glfwSetWindowRefreshCallback(window, windowRefreshCallback);
+
+	ImGui::StyleColorsDark();
+	if (!buildImGuiFonts(options)) {
+		glfwTerminate();
+		return -1;
+	}
+
+	// Add GLEW for OpenGL access
+	glewExperimental = GL_TRUE;
+
+	GLenum glewInitialize = glewInit();
+	if (glewInitialize != GLEW_OK) {
+		std::cout << "Error glewInit: " << glewGetErrorString(glewInitialize);
+		glfwTerminate();
+		return -1;
+	}
+
+	// Optional hidden window whose context shares objects with ours, shader variants get built on it
+	GLFWwindow* compileWindow = nullptr;
+	std::unique_ptr<ShaderCompileQueue> compileQueue;
+	if (options.asyncShaders)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		compileWindow = glfwCreateWindow(1, 1, "Matrices Visualizer (shaders)", NULL, window);
+		if (compileWindow)
+		{
+			compileQueue.reset(new ShaderCompileQueue(
+				[compileWindow]() { glfwMakeContextCurrent(compileWindow); return true; },
+				[]() { glfwMakeContextCurrent(NULL); }));
+		}
+		if (!compileQueue) logString("No shared context, shaders are built on the render thread");
 	}
 
+	// Everything owning GL objects lives in runWindowed and is released before the context is torn down
+	int result = runWindowed(options, window, compileQueue.get());
+
+	// Programs still building would otherwise outlive the worker context
+	if (compileQueue)
+	{
+		compileQueue->WaitUntilIdle();
+		compileQueue.reset();
+	}
+	if (compileWindow) glfwDestroyWindow(compileWindow);
+
 	ImGui_ImplGlfwGL3_Shutdown();
 	ImGui::DestroyContext();
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
-	return 0;
+	return result;
 }
 
 void frameBufferSizeCallback(GLFWwindow* window, int widthOfFramebuffer, int heightOfFramebuffer)
@@ -356,4 +1138,13 @@ void frameBufferSizeCallback(GLFWwindow* window, int widthOfFramebuffer, int hei
 	}*/
 
 	glViewport(0, 0, widthOfFramebuffer, heightOfFramebuffer);
+	recordInputEvent(InputEventType::FramebufferSize, widthOfFramebuffer, heightOfFramebuffer);
+
+	// Minimized windows report 0x0, keep the last aspect ratio for the projection
+	if (widthOfFramebuffer > 0 && heightOfFramebuffer > 0)
+	{
+		width = widthOfFramebuffer;
+		height = heightOfFramebuffer;
+	}
+	markInputEvent();
 };